@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/fileutils.h"
+#include "../common/protocol.h"
+
+// sends inputs to a running build/aoc-server and prints the answers the same way the day binaries do
+//
+//   aoc-client [--socket <path>] <dayXX> <input> [<dayXX> <input> ...]
+//
+// with more than one input the day name is printed before its parts, like build/aoc does. all inputs go over the same
+// connection
+
+int main(int argc, char **argv) {
+  const char *socket_path = PROTOCOL_DEFAULT_SOCKET;
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+      socket_path = argv[++i];
+    else
+      argv[out++] = argv[i];
+  }
+  argc = out;
+  if (argc < 3 || argc % 2 == 0) {
+    fprintf(stderr, "usage: %s [--socket <path>] <dayXX> <input> [<dayXX> <input> ...]\n", argv[0]);
+    return 1;
+  }
+
+  const int fd = protocol_connect(socket_path);
+  if (fd < 0)
+    return 1;
+
+  int status = 0;
+  for (int i = 1; i < argc && status == 0; i += 2) {
+    const uint32_t day = protocol_parse_day(argv[i]);
+    if (day == 0) {
+      fprintf(stderr, "unknown day '%s'\n", argv[i]);
+      status = 1;
+      break;
+    }
+    char *input = NULL;
+    size_t length = 0;
+    if (!fileutils_read_all(argv[i + 1], &input, &length)) {
+      status = 1;
+      break;
+    }
+
+    protocol_response response = {0};
+    const bool answered = protocol_solve(fd, day, input, length - 1, &response);
+    free(input);
+    if (!answered) {
+      fprintf(stderr, "the server closed the connection\n");
+      status = 1;
+    } else if (response.status != PROTOCOL_STATUS_OK) {
+      fprintf(stderr, "%s: %s\n", argv[i + 1], protocol_status_string(response.status));
+      status = 1;
+    } else {
+      if (argc > 3)
+        printf("day%02u\n", day);
+      // same as aoc_print, day 1 prints both parts on one line
+      if (day == 1 && response.part_count > 1) {
+        printf("%lu %lu\n", response.part1, response.part2);
+      } else {
+        printf("%lu\n", response.part1);
+        if (response.part_count > 1)
+          printf("%lu\n", response.part2);
+      }
+    }
+  }
+  close(fd);
+  return status;
+}
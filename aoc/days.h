@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../common/aoc.h"
+
+// every day linked into the process. in order, days[n - 1] is day n
+static const aoc_day days[] = {
+    AOC_DAY(day01), AOC_DAY(day02), AOC_DAY(day03), AOC_DAY(day04), AOC_DAY(day05), AOC_DAY(day06),
+    AOC_DAY(day07), AOC_DAY(day08), AOC_DAY(day09), AOC_DAY(day10), AOC_DAY(day11), AOC_DAY(day12),
+};
+#define DAY_COUNT (sizeof(days) / sizeof(days[0]))
+
+static inline const aoc_day *find_day(const char *name) {
+  for (uint32_t i = 0; i < DAY_COUNT; ++i) {
+    if (strcmp(days[i].name, name) == 0)
+      return &days[i];
+  }
+  fprintf(stderr, "unknown day '%s'\n", name);
+  return NULL;
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../common/aoc.h"
+#include "../common/pool.h"
+#include "days.h"
+
+// all days in one process. they run back to back, so the process start and the sanitizer setup are only paid once
+//
+//   aoc [options] <dayXX> <input> [<dayXX> <input> ...]
+//   aoc [options] all   every day which has a dayXX/input.txt
+//
+//   --parallel       run every input as a task on a work-stealing pool. days with independent parts (05, 06, 09) fork
+//                    those as well. prints the wall time against the cpu time of all threads
+//   --threads <n>    pool threads besides the main thread (default: cpus - 1)
+//
+// the bench and cache options are the same as for the single day binaries and apply to every day. the bench options
+// don't work together with --parallel because the phases of concurrent days would end up in the same bench
+
+typedef struct job {
+  const aoc_day *day;
+  const char *file_name;
+  aoc_result result;
+  cache *cache;
+  bool solved;
+} job;
+
+static bool run_day(const aoc_day *const d, void *const state, cache *const c, const char *const file_name,
+                    const bench_options *const options) {
+  bench b = {0};
+  bench_create(&b, d->name, options);
+  aoc_result result = {0};
+  const bool solved = aoc_run(&b, file_name, d, state, c, &result);
+  if (solved) {
+    printf("%s\n", d->name);
+    aoc_print(stdout, d, &result);
+    fflush(stdout);
+    bench_report(&b);
+  }
+  bench_destroy(&b);
+  return solved;
+}
+
+static void job_task(void *arg) {
+  job *const j = arg;
+  fileutils_mapping input = {0};
+  if (!fileutils_map(j->file_name, &input))
+    return;
+  // states can't be shared between concurrent tasks
+  void *const state = j->day->create();
+  aoc_solve(j->day, state, j->cache, input.data, input.length - 1, &j->result);
+  j->day->destroy(state);
+  fileutils_unmap(&input);
+  j->solved = true;
+}
+
+static uint64_t now_ns(const clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// user + system time of all threads. includes the spinning of idle workers, which is part of the price
+static uint64_t process_cpu_ns(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * 1000000000ull +
+         ((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * 1000ull;
+}
+
+static void job_range(void *arg, const uint64_t begin, const uint64_t end) {
+  job *const jobs = arg;
+  for (uint64_t i = begin; i < end; ++i)
+    job_task(&jobs[i]);
+}
+
+static bool run_parallel(job *const jobs, const uint32_t job_count, const uint32_t thread_count) {
+  pool p = {0};
+  if (!pool_create(&p, thread_count))
+    return false;
+
+  const uint64_t wall_start = now_ns(CLOCK_MONOTONIC);
+  const uint64_t cpu_start = process_cpu_ns();
+
+  // the range gets halved until every job is a task of its own. only the halves waiting to be split sit in the
+  // deques, so any number of inputs fits
+  pool_parallel_for(0, job_count, 1, job_range, jobs);
+
+  const uint64_t wall = now_ns(CLOCK_MONOTONIC) - wall_start;
+  const uint64_t cpu = process_cpu_ns() - cpu_start;
+  const uint32_t threads = p.thread_count + 1;
+  pool_destroy(&p);
+
+  bool all_solved = true;
+  for (uint32_t i = 0; i < job_count; ++i) {
+    if (!jobs[i].solved) {
+      all_solved = false;
+      continue;
+    }
+    printf("%s\n", jobs[i].day->name);
+    aoc_print(stdout, jobs[i].day, &jobs[i].result);
+  }
+  fprintf(stderr, "%u inputs on %u threads: wall %.2f ms, cpu %.2f ms (%.2f cores busy)\n", job_count, threads,
+          wall / 1e6, cpu / 1e6, wall > 0 ? (double)cpu / wall : 0.0);
+  return all_solved;
+}
+
+int main(int argc, char **argv) {
+  bench_options options = {0};
+  cache_options cache_options = {0};
+  if (!bench_parse_options(&options, &argc, argv) || !cache_parse_options(&cache_options, &argc, argv))
+    return 1;
+
+  bool parallel = false;
+  uint32_t thread_count = 0;
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--parallel") == 0) {
+      parallel = true;
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      thread_count = strtoul(argv[++i], NULL, 10);
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  argc = out;
+
+  job *jobs = calloc(argc > (int)DAY_COUNT ? argc : DAY_COUNT, sizeof(job));
+  uint32_t job_count = 0;
+  if (argc == 2 && strcmp(argv[1], "all") == 0) {
+    static char file_names[DAY_COUNT][32];
+    for (uint32_t i = 0; i < DAY_COUNT; ++i) {
+      snprintf(file_names[i], sizeof(file_names[i]), "%s/input.txt", days[i].name);
+      if (access(file_names[i], R_OK) == 0)
+        jobs[job_count++] = (job){.day = &days[i], .file_name = file_names[i]};
+    }
+  } else if (argc >= 3 && argc % 2 == 1) {
+    for (int i = 1; i < argc; i += 2) {
+      const aoc_day *const d = find_day(argv[i]);
+      if (!d) {
+        free(jobs);
+        return 1;
+      }
+      jobs[job_count++] = (job){.day = d, .file_name = argv[i + 1]};
+    }
+  } else {
+    fprintf(stderr,
+            "usage: %s [--bench <n>] [--bench-json <file>] [--counters] [--trace <file>] <dayXX> <input> "
+            "[<dayXX> <input> ...]\n"
+            "       %s [--bench <n>] [--counters] all\n"
+            "       %s --parallel [--threads <n>] <dayXX> <input> [<dayXX> <input> ...] | all\n"
+            "cache options: --cache, --no-cache, --cache-dir <dir>, --cache-entries <n>, --cache-stats\n",
+            argv[0], argv[0], argv[0]);
+    free(jobs);
+    return 1;
+  }
+
+  if (parallel && options.enabled) {
+    fprintf(stderr, "the bench options don't work together with --parallel\n");
+    free(jobs);
+    return 1;
+  }
+  if ((options.json_file || options.trace_file) && job_count > 1) {
+    fprintf(stderr, "--bench-json and --trace only work with a single day\n");
+    free(jobs);
+    return 1;
+  }
+
+  // benchmarks and counters measure the solvers, not the cache
+  cache c = {0};
+  cache_options.disabled |= options.enabled || COUNTERS_ENABLED;
+  cache_open(&c, &cache_options);
+  for (uint32_t i = 0; i < job_count; ++i)
+    jobs[i].cache = &c;
+
+  bool solved = true;
+  if (parallel) {
+    solved = run_parallel(jobs, job_count, thread_count);
+  } else {
+    // one state per day, reused when a day shows up more than once
+    void *states[DAY_COUNT] = {0};
+    for (uint32_t i = 0; i < job_count && solved; ++i) {
+      const uint32_t d = jobs[i].day - days;
+      if (!states[d])
+        states[d] = days[d].create();
+      solved = run_day(jobs[i].day, states[d], jobs[i].cache, jobs[i].file_name, &options);
+    }
+    for (uint32_t i = 0; i < DAY_COUNT; ++i) {
+      if (states[i])
+        days[i].destroy(states[i]);
+    }
+  }
+  if (cache_options.stats)
+    cache_print_stats(&c, stderr);
+  cache_close(&c);
+  free(jobs);
+  return solved ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../common/aoc.h"
+#include "../common/pool.h"
+#include "../common/protocol.h"
+#include "days.h"
+
+// keeps all days resident and solves inputs sent over a unix socket (see common/protocol.h). a request only pays for
+// reading its input and solving it, no process start, no dynamic linking, no allocations once a worker is warm
+//
+//   aoc-server [--socket <path>] [--workers <n>] [cache options]
+//
+//   --socket <path>   where to listen (default /tmp/aoc.sock)
+//   --workers <n>     connections served at the same time (default: number of cpus)
+//   cache options     see common/cache.h. all workers share the cache
+//
+// every worker owns the states of all days and an input buffer. they are created up front and only ever cleared by the
+// days, so the arenas and hashmaps of day 07, 08, 10 and 11 keep their capacity between requests. the first request of
+// a day on a worker still touches the pages of its state for the first time
+//
+// trust: the parsers are written for well formed puzzle inputs and don't bounds check every write. so the socket is
+// only open to the user who started the server (see protocol_listen), the same trust as running a day binary on a file.
+// on top of that every input is checked before it's solved:
+// - it has to be made of the characters of its day only (input_alphabets). stray or binary data, and a zero byte in
+//   the middle, gets an invalid input response instead of reaching the parser
+// - the days are linked with their asserts kept in release builds as well (see the Makefile). an input in the right
+//   characters but with the wrong structure mostly trips one of them and aborts the server instead of running on with
+//   out of bounds reads and writes. not every write is guarded though, so this is damage control, not a sandbox
+
+#define INITIAL_BUFFER_SIZE (64 * 1024)
+
+typedef struct worker {
+  pthread_t thread;
+  int listen_fd;
+  cache *cache;
+  void *states[DAY_COUNT];
+  char *buffer;
+  size_t capacity; // without the zero terminator
+} worker;
+
+static const char *socket_path = PROTOCOL_DEFAULT_SOCKET;
+
+// every character the input of a day can contain, input_alphabets[n - 1] is day n
+static const char *const input_alphabets[DAY_COUNT] = {
+    "LR0123456789\n",          "0123456789-,\n", "0123456789\n",       "@.\n",
+    "0123456789-\n",           "0123456789+* \n", "S.^\n",              "0123456789,\n",
+    "0123456789,\n",           "0123456789[].#(),{} \n",
+    "abcdefghijklmnopqrstuvwxyz: \n",              "0123456789.#x: \n",
+};
+
+// the buffer is zero terminated, so strspn stops at a zero byte inside the input as well
+static inline bool input_valid(const uint32_t day, const char *const input, const size_t length) {
+  return length > 0 && strspn(input, input_alphabets[day - 1]) == length;
+}
+
+static void on_signal(const int signal) {
+  (void)signal;
+  unlink(socket_path);
+  _exit(0);
+}
+
+// answers requests until the client hangs up or sends garbage
+static void serve(worker *const w, const int fd) {
+  protocol_request request;
+  while (protocol_read_all(fd, &request, sizeof(request))) {
+    protocol_response response = {.status = PROTOCOL_STATUS_OK};
+    if (request.day < 1 || request.day > DAY_COUNT)
+      response.status = PROTOCOL_STATUS_UNKNOWN_DAY;
+    else if (request.length > PROTOCOL_MAX_INPUT)
+      response.status = PROTOCOL_STATUS_INPUT_TOO_BIG;
+    if (response.status != PROTOCOL_STATUS_OK) {
+      protocol_write_all(fd, &response, sizeof(response));
+      return;
+    }
+
+    if (request.length > w->capacity) {
+      while (w->capacity < request.length)
+        w->capacity *= 2;
+      w->buffer = realloc(w->buffer, w->capacity + 1);
+    }
+    if (!protocol_read_all(fd, w->buffer, request.length))
+      return;
+    w->buffer[request.length] = '\0';
+    if (!input_valid(request.day, w->buffer, request.length)) {
+      response.status = PROTOCOL_STATUS_INVALID_INPUT;
+      protocol_write_all(fd, &response, sizeof(response));
+      return;
+    }
+
+    const aoc_day *const d = &days[request.day - 1];
+    aoc_result result = {0};
+    aoc_solve(d, w->states[request.day - 1], w->cache, w->buffer, request.length, &result);
+    response.part_count = result.part_count;
+    response.part1 = result.part1;
+    response.part2 = result.part2;
+    if (!protocol_write_all(fd, &response, sizeof(response)))
+      return;
+  }
+}
+
+static void *worker_main(void *arg) {
+  worker *const w = arg;
+  for (;;) {
+    const int fd = accept(w->listen_fd, NULL, NULL);
+    if (fd < 0) {
+      perror("accept");
+      continue;
+    }
+    serve(w, fd);
+    close(fd);
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  uint32_t worker_count = pool_default_thread_count();
+  cache_options cache_options = {0};
+  if (!cache_parse_options(&cache_options, &argc, argv))
+    return 1;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      worker_count = strtoul(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--socket <path>] [--workers <n>] [cache options]\n", argv[0]);
+      fprintf(stderr, "cache options: --cache, --no-cache, --cache-dir <dir>, --cache-entries <n>\n");
+      return 1;
+    }
+  }
+  if (worker_count == 0) {
+    fprintf(stderr, "need at least one worker\n");
+    return 1;
+  }
+
+  const int listen_fd = protocol_listen(socket_path);
+  if (listen_fd < 0)
+    return 1;
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  static cache c;
+  cache_open(&c, &cache_options);
+
+  worker *workers = calloc(worker_count, sizeof(worker));
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    worker *const w = &workers[i];
+    w->listen_fd = listen_fd;
+    w->cache = &c;
+    for (uint32_t d = 0; d < DAY_COUNT; ++d)
+      w->states[d] = days[d].create();
+    w->capacity = INITIAL_BUFFER_SIZE;
+    w->buffer = malloc(w->capacity + 1);
+    memset(w->buffer, 0, w->capacity + 1); // fault the pages in now instead of on the first request
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+      fprintf(stderr, "couldn't start worker %u\n", i);
+      unlink(socket_path);
+      return 1;
+    }
+  }
+  fprintf(stderr, "listening on %s with %u workers\n", socket_path, worker_count);
+
+  // the workers never return. the signal handler ends the process
+  for (uint32_t i = 0; i < worker_count; ++i)
+    pthread_join(workers[i].thread, NULL);
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../common/fastint.h"
+
+// compares strtoull with fastint_parse_u64 on newline separated numbers of different widths
+// build with `make release=1 build/bench/fastint` (add CFLAGS+=-msse4.1 for the 16 digit path)
+
+#define NUMBER_COUNT 1000000
+#define ROUNDS 10
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static char *generate(const uint32_t max_digits, const uint32_t seed) {
+  char *buffer = malloc((size_t)NUMBER_COUNT * (max_digits + 1) + 1);
+  char *out = buffer;
+  srand(seed);
+  for (uint32_t i = 0; i < NUMBER_COUNT; ++i) {
+    const uint32_t digits = 1 + rand() % max_digits;
+    *out++ = '1' + rand() % 9;
+    for (uint32_t d = 1; d < digits; ++d)
+      *out++ = '0' + rand() % 10;
+    *out++ = '\n';
+  }
+  *out = '\0';
+  return buffer;
+}
+
+typedef uint64_t (*parse_func)(const char *, char **);
+
+static uint64_t parse_strtoull(const char *p, char **end) {
+  return strtoull(p, end, 10);
+}
+
+static double run(const char *input, const parse_func parse, uint64_t *const checksum) {
+  double best = 1e9;
+  for (uint32_t round = 0; round < ROUNDS; ++round) {
+    uint64_t sum = 0;
+    char *p = (char *)input;
+    const double start = now();
+    while (*p != '\0') {
+      sum += parse(p, &p);
+      ++p; // skip new line
+    }
+    const double elapsed = now() - start;
+    best = elapsed < best ? elapsed : best;
+    *checksum = sum;
+  }
+  return best;
+}
+
+int main(void) {
+  static const uint32_t widths[] = {3, 5, 8, 15, 19};
+  printf("%-10s %14s %14s %8s\n", "digits", "strtoull ns", "fastint ns", "speedup");
+  for (uint32_t i = 0; i < sizeof(widths) / sizeof(widths[0]); ++i) {
+    char *input = generate(widths[i], i + 1);
+    uint64_t expected = 0;
+    uint64_t actual = 0;
+    const double baseline = run(input, parse_strtoull, &expected);
+    const double fast = run(input, fastint_parse_u64, &actual);
+    if (expected != actual) {
+      fprintf(stderr, "checksum mismatch for %u digits: %lu != %lu\n", widths[i], expected, actual);
+      return 1;
+    }
+    printf("1-%-8u %14.2f %14.2f %7.2fx\n", widths[i], baseline * 1e9 / NUMBER_COUNT, fast * 1e9 / NUMBER_COUNT,
+           baseline / fast);
+    free(input);
+  }
+}
@@ -0,0 +1,209 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/fileutils.h"
+#include "../common/protocol.h"
+
+// load test for build/aoc-server. every connection is a thread which sends the same input over and over and measures
+// the time from sending the request to having the whole response
+//
+//   load [options] <dayXX> <input>
+//
+//   --socket <path>       server socket (default /tmp/aoc.sock)
+//   --connections <n>     concurrent clients (default 1)
+//   --requests <n>        requests per client (default 1000)
+//   --reconnect           open a new connection for every request
+//   --spawn               no server. start build/dayXX per request instead, for comparison
+//
+// prints the throughput and the latency percentiles. fails if any request failed or the answers differ
+
+extern char **environ;
+
+typedef struct options {
+  const char *socket_path;
+  uint32_t connections;
+  uint32_t requests;
+  bool reconnect;
+  bool spawn;
+  uint32_t day;
+  const char *day_name;
+  const char *file_name;
+  const char *input;
+  size_t length;
+} options;
+
+typedef struct client {
+  pthread_t thread;
+  const options *o;
+  uint64_t *latencies; // requests of them
+  uint32_t failed;
+  protocol_response first;
+  bool mismatch;
+} client;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool spawn_day(const options *const o) {
+  char path[64];
+  snprintf(path, sizeof(path), "build/%s", o->day_name);
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  char *const args[] = {path, (char *)o->file_name, NULL};
+  pid_t pid;
+  const bool started = posix_spawn(&pid, path, &actions, NULL, args, environ) == 0;
+  posix_spawn_file_actions_destroy(&actions);
+  int status = 0;
+  return started && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void record(client *const c, const protocol_response *const response, const uint32_t i) {
+  if (response->status != PROTOCOL_STATUS_OK) {
+    c->failed++;
+    return;
+  }
+  if (i == 0)
+    c->first = *response;
+  else if (response->part1 != c->first.part1 || response->part2 != c->first.part2)
+    c->mismatch = true;
+}
+
+static void *client_main(void *arg) {
+  client *const c = arg;
+  const options *const o = c->o;
+  int fd = -1;
+  for (uint32_t i = 0; i < o->requests; ++i) {
+    const uint64_t start = now_ns();
+    if (o->spawn) {
+      if (!spawn_day(o))
+        c->failed++;
+    } else {
+      if (fd < 0)
+        fd = protocol_connect(o->socket_path);
+      protocol_response response = {0};
+      if (fd < 0 || !protocol_solve(fd, o->day, o->input, o->length, &response)) {
+        c->failed++;
+        if (fd >= 0)
+          close(fd);
+        fd = -1;
+      } else {
+        record(c, &response, i);
+        if (o->reconnect) {
+          close(fd);
+          fd = -1;
+        }
+      }
+    }
+    c->latencies[i] = now_ns() - start;
+  }
+  if (fd >= 0)
+    close(fd);
+  return NULL;
+}
+
+static int u64_compare(const void *left, const void *right) {
+  const uint64_t l = *(const uint64_t *)left;
+  const uint64_t r = *(const uint64_t *)right;
+  return (l > r) - (l < r);
+}
+
+// nearest rank on sorted samples
+static double percentile_us(const uint64_t *const sorted, const uint64_t count, const double p) {
+  uint64_t rank = (uint64_t)(p / 100.0 * count + 0.5);
+  rank = rank == 0 ? 1 : rank > count ? count : rank;
+  return sorted[rank - 1] / 1e3;
+}
+
+int main(int argc, char **argv) {
+  options o = {.socket_path = PROTOCOL_DEFAULT_SOCKET, .connections = 1, .requests = 1000};
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+      o.socket_path = argv[++i];
+    else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc)
+      o.connections = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc)
+      o.requests = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--reconnect") == 0)
+      o.reconnect = true;
+    else if (strcmp(argv[i], "--spawn") == 0)
+      o.spawn = true;
+    else
+      argv[out++] = argv[i];
+  }
+  if (out != 3 || o.connections == 0 || o.requests == 0) {
+    fprintf(stderr,
+            "usage: %s [--socket <path>] [--connections <n>] [--requests <n>] [--reconnect] [--spawn] <dayXX> "
+            "<input>\n",
+            argv[0]);
+    return 1;
+  }
+  o.day = protocol_parse_day(argv[1]);
+  if (o.day == 0) {
+    fprintf(stderr, "unknown day '%s'\n", argv[1]);
+    return 1;
+  }
+  static char day_name[8];
+  snprintf(day_name, sizeof(day_name), "day%02u", o.day);
+  o.day_name = day_name;
+  o.file_name = argv[2];
+
+  char *input = NULL;
+  size_t length = 0;
+  if (!fileutils_read_all(o.file_name, &input, &length))
+    return 1;
+  o.input = input;
+  o.length = length - 1;
+
+  client *clients = calloc(o.connections, sizeof(client));
+  uint64_t *latencies = malloc(sizeof(uint64_t) * o.connections * o.requests);
+  const uint64_t start = now_ns();
+  for (uint32_t i = 0; i < o.connections; ++i) {
+    clients[i] = (client){.o = &o, .latencies = &latencies[(uint64_t)i * o.requests]};
+    if (pthread_create(&clients[i].thread, NULL, client_main, &clients[i]) != 0) {
+      fprintf(stderr, "couldn't start client %u\n", i);
+      return 1;
+    }
+  }
+
+  uint32_t failed = 0;
+  bool mismatch = false;
+  for (uint32_t i = 0; i < o.connections; ++i) {
+    pthread_join(clients[i].thread, NULL);
+    failed += clients[i].failed;
+    mismatch |= clients[i].mismatch || (i > 0 && !o.spawn && (clients[i].first.part1 != clients[0].first.part1 ||
+                                                              clients[i].first.part2 != clients[0].first.part2));
+  }
+  const uint64_t wall = now_ns() - start;
+
+  const uint64_t count = (uint64_t)o.connections * o.requests;
+  qsort(latencies, count, sizeof(uint64_t), u64_compare);
+  printf("%s %s: %lu requests on %u connections%s in %.2f ms, %.0f requests/s\n", o.spawn ? "spawn" : "server",
+         o.day_name, count, o.connections, o.reconnect ? " (reconnecting)" : "", wall / 1e6,
+         wall > 0 ? count / (wall / 1e9) : 0.0);
+  printf("latency us: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n", percentile_us(latencies, count, 50),
+         percentile_us(latencies, count, 90), percentile_us(latencies, count, 99),
+         percentile_us(latencies, count, 99.9), latencies[count - 1] / 1e3);
+  if (failed > 0)
+    fprintf(stderr, "%u requests failed\n", failed);
+  if (mismatch)
+    fprintf(stderr, "the answers differ between requests\n");
+
+  free(latencies);
+  free(clients);
+  free(input);
+  return failed > 0 || mismatch ? 1 : 0;
+}
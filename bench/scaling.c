@@ -0,0 +1,193 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "../common/fileutils.h"
+
+// runs every day on generated inputs of growing size and fits the growth exponent of the time per iteration against
+// the input size (time ~ size^k). fails if k got worse than the recorded one, so an O(n log n) path turning back into
+// O(n^2) gets noticed. expects the days and generators to be built already, `make scaling release=1` does all of it
+//
+//   --scales <list>    generator scales, comma or space separated (default 0.125,0.25,0.5,1)
+//   --iterations <n>   bench iterations per size (default 10)
+//   --out <dir>        where the inputs and the json results go (default build/scaling)
+//   dayXX ...          only run these days
+//
+// writes <out>/dayXX.json per day with the measurements and the fit
+
+#define MAX_SCALES 16
+#define MAX_PATH 256
+
+// allowed increase of the exponent before it counts as regression. small inputs are noisy and the fixed costs of a
+// day flatten the curve at the low end, so this can't be much tighter
+#define TOLERANCE 0.3
+
+typedef struct expectation {
+  const char *day;
+  double exponent;
+  const char *why;
+} expectation;
+
+// measured with `make scaling release=1`, rounded up a bit
+static const expectation expectations[] = {
+    {"day01", 1.0, "one pass over the rotations"},
+    {"day02", 1.0, "constant work per range, fixed costs dominate small inputs"},
+    {"day03", 1.0, "one pass per bank"},
+    {"day04", 1.6, "grid sweep per round and the number of rounds grows with the grid"},
+    {"day05", 1.0, "sort of the ranges, binary search per id"},
+    {"day06", 1.1, "one pass over the columns"},
+    {"day07", 1.0, "memoized dfs over the splitters"},
+    {"day08", 1.4, "n^2 distances, fixed costs flatten the curve at these sizes"},
+    {"day09", 2.5, "n^2 rectangles checked against n edges, most rejected early"},
+    {"day10", 1.2, "bfs per machine"},
+    {"day11", 1.6, "memoized dfs, the node map inserts while parsing dominate"},
+    {"day12", 1.0, "constant work per region"},
+};
+#define EXPECTATION_COUNT (sizeof(expectations) / sizeof(expectations[0]))
+
+typedef struct sample {
+  double scale;
+  uint64_t bytes;
+  uint64_t min_ns;
+  uint64_t median_ns;
+} sample;
+
+static bool read_total(const char *path, uint64_t *const min_ns, uint64_t *const median_ns) {
+  char *json = NULL;
+  size_t length = 0;
+  if (!fileutils_read_all(path, &json, &length))
+    return false;
+  const char *total = strstr(json, "\"total\":");
+  const bool found = total && sscanf(total, "\"total\":{\"min_ns\":%lu,\"median_ns\":%lu", min_ns, median_ns) == 2;
+  free(json);
+  return found;
+}
+
+// least squares slope in log-log space
+static double fit_exponent(const sample *const samples, const uint32_t count) {
+  double mean_x = 0, mean_y = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    mean_x += log((double)samples[i].bytes) / count;
+    mean_y += log((double)samples[i].min_ns) / count;
+  }
+  double covariance = 0, variance = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    const double dx = log((double)samples[i].bytes) - mean_x;
+    const double dy = log((double)samples[i].min_ns) - mean_y;
+    covariance += dx * dy;
+    variance += dx * dx;
+  }
+  return variance > 0 ? covariance / variance : 0;
+}
+
+static bool run_day(const expectation *const e, const double *const scales, const uint32_t scale_count,
+                    const uint32_t iterations, const char *const out_dir) {
+  sample samples[MAX_SCALES] = {0};
+  char input[MAX_PATH], json[MAX_PATH], command[4 * MAX_PATH];
+  for (uint32_t i = 0; i < scale_count; ++i) {
+    snprintf(input, sizeof(input), "%s/%s-x%g.txt", out_dir, e->day, scales[i]);
+    snprintf(json, sizeof(json), "%s/%s-x%g.json", out_dir, e->day, scales[i]);
+
+    snprintf(command, sizeof(command), "build/gen/%s --scale %g > %s", e->day, scales[i], input);
+    if (system(command) != 0) {
+      fprintf(stderr, "generating '%s' failed\n", input);
+      return false;
+    }
+    snprintf(command, sizeof(command), "build/%s --bench %u --bench-json %s %s > /dev/null 2>&1", e->day, iterations,
+             json, input);
+    if (system(command) != 0) {
+      fprintf(stderr, "%s failed on '%s'. rerun it by hand to see why\n", e->day, input);
+      return false;
+    }
+
+    struct stat st;
+    samples[i].scale = scales[i];
+    samples[i].bytes = stat(input, &st) == 0 ? (uint64_t)st.st_size : 0;
+    if (!read_total(json, &samples[i].min_ns, &samples[i].median_ns) || samples[i].bytes == 0 ||
+        samples[i].min_ns == 0) {
+      fprintf(stderr, "no usable measurement in '%s'\n", json);
+      return false;
+    }
+  }
+
+  const double exponent = fit_exponent(samples, scale_count);
+  const bool passed = exponent <= e->exponent + TOLERANCE;
+  printf("%-6s %8.2f %9.2f   %-10s %s\n", e->day, exponent, e->exponent, passed ? "ok" : "REGRESSED", e->why);
+
+  snprintf(json, sizeof(json), "%s/%s.json", out_dir, e->day);
+  FILE *f = fopen(json, "w");
+  if (!f) {
+    fprintf(stderr, "couldn't open file '%s'\n", json);
+    return false;
+  }
+  fprintf(f, "{\"name\":\"%s\",\"exponent\":%.3f,\"expected_exponent\":%.2f,\"tolerance\":%.2f,", e->day, exponent,
+          e->exponent, TOLERANCE);
+  fprintf(f, "\"passed\":%s,\"samples\":[", passed ? "true" : "false");
+  for (uint32_t i = 0; i < scale_count; ++i) {
+    fprintf(f, "%s{\"scale\":%g,\"bytes\":%lu,\"min_ns\":%lu,\"median_ns\":%lu}", i == 0 ? "" : ",", samples[i].scale,
+            samples[i].bytes, samples[i].min_ns, samples[i].median_ns);
+  }
+  fprintf(f, "]}\n");
+  fclose(f);
+  return passed;
+}
+
+static uint32_t parse_scales(const char *list, double *const scales) {
+  uint32_t count = 0;
+  char *end = NULL;
+  while (*list != '\0' && count < MAX_SCALES) {
+    const double scale = strtod(list, &end);
+    if (end == list) {
+      ++list; // separator
+      continue;
+    }
+    scales[count++] = scale;
+    list = end;
+  }
+  return count;
+}
+
+int main(int argc, char **argv) {
+  double scales[MAX_SCALES] = {0.125, 0.25, 0.5, 1};
+  uint32_t scale_count = 4;
+  uint32_t iterations = 10;
+  const char *out_dir = "build/scaling";
+  const char *days[EXPECTATION_COUNT] = {0};
+  uint32_t day_count = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--scales") == 0 && i + 1 < argc) {
+      scale_count = parse_scales(argv[++i], scales);
+    } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_dir = argv[++i];
+    } else if (day_count < EXPECTATION_COUNT) {
+      days[day_count++] = argv[i];
+    }
+  }
+  if (scale_count < 2 || iterations == 0) {
+    fprintf(stderr, "need at least two scales and one iteration\n");
+    return 1;
+  }
+
+  char command[MAX_PATH + 16];
+  snprintf(command, sizeof(command), "mkdir -p %s", out_dir);
+  if (system(command) != 0)
+    return 1;
+
+  printf("%-6s %8s %9s   %-10s\n", "day", "exponent", "expected", "result");
+  bool all_passed = true;
+  for (uint32_t i = 0; i < EXPECTATION_COUNT; ++i) {
+    bool selected = day_count == 0;
+    for (uint32_t j = 0; j < day_count; ++j)
+      selected |= strcmp(days[j], expectations[i].day) == 0;
+    if (selected)
+      all_passed &= run_day(&expectations[i], scales, scale_count, iterations, out_dir);
+  }
+  return all_passed ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../ext/toolbelt/src/assert.h"
+#include "bench.h"
+#include "cache.h"
+#include "counters.h"
+#include "dispatch.h"
+#include "fileutils.h"
+#include "pool.h"
+
+// every day is a library function which solves one input that is already in memory. the input has to be zero
+// terminated (input[length] == '\0'), which the fileutils loaders guarantee. the dayXX binaries are a thin main around
+// it and build/aoc links all of them into one process
+//
+// compiling a day with -DAOC_LIBRARY leaves out its main
+
+typedef struct aoc_result {
+  uint64_t part1;
+  uint64_t part2;
+  uint8_t part_count; // day 12 only has one part and part 2 of day 10 isn't solved yet
+} aoc_result;
+
+typedef void (*aoc_solve_func)(const char *input, size_t length, aoc_result *out);
+
+// a day keeps its buffers and containers in a state which is created once and then reused for every input it solves.
+// solve resets whatever the previous input left behind instead of allocating (and zeroing) everything again. a state
+// can only solve one input at a time
+typedef struct aoc_day {
+  const char *name;
+  void *(*create)(void);
+  void (*solve)(void *state, const char *input, size_t length, aoc_result *out);
+  void (*destroy)(void *state);
+  // only for days which support snapshots of their parsed input (see snapshot.h). NULL for the others
+  bool (*emit_snapshot)(void *state, const char *input, size_t length, const char *file_name);
+  bool (*solve_snapshot)(void *state, const char *file_name, aoc_result *out);
+} aoc_day;
+
+#define AOC_DAY(day) {#day, day##_create, day##_solve_with, day##_destroy, NULL, NULL}
+#define AOC_DAY_WITH_SNAPSHOT(day)                                                                                     \
+  {#day, day##_create, day##_solve_with, day##_destroy, day##_emit_snapshot, day##_solve_snapshot}
+
+#define AOC_DAY_DECLARE(day)                                                                                           \
+  void *day##_create(void);                                                                                            \
+  void day##_solve_with(void *state, const char *input, size_t length, aoc_result *out);                              \
+  void day##_destroy(void *state);                                                                                     \
+  void day##_solve(const char *input, size_t length, aoc_result *out);
+
+// dayXX_solve for a single input. pays the state setup every call
+#define AOC_DAY_DEFINE_SOLVE(day)                                                                                      \
+  void day##_solve(const char *const input, const size_t length, aoc_result *const out) {                             \
+    void *const state = day##_create();                                                                                \
+    day##_solve_with(state, input, length, out);                                                                       \
+    day##_destroy(state);                                                                                              \
+  }
+
+#define AOC_DAY_DECLARE_SNAPSHOT(day)                                                                                  \
+  bool day##_emit_snapshot(void *state, const char *input, size_t length, const char *file_name);                     \
+  bool day##_solve_snapshot(void *state, const char *file_name, aoc_result *out);
+
+AOC_DAY_DECLARE(day01)
+AOC_DAY_DECLARE(day02)
+AOC_DAY_DECLARE(day03)
+AOC_DAY_DECLARE(day04)
+AOC_DAY_DECLARE(day05)
+AOC_DAY_DECLARE(day06)
+AOC_DAY_DECLARE(day07)
+AOC_DAY_DECLARE(day08)
+AOC_DAY_DECLARE(day09)
+AOC_DAY_DECLARE(day10)
+AOC_DAY_DECLARE(day11)
+AOC_DAY_DECLARE(day12)
+AOC_DAY_DECLARE_SNAPSHOT(day06)
+AOC_DAY_DECLARE_SNAPSHOT(day10)
+AOC_DAY_DECLARE_SNAPSHOT(day11)
+
+// the parsers only read but they move a plain char pointer through the input (strtoul style end pointers)
+static inline char *aoc_input(const char *const input, const size_t length) {
+  tlbt_assert_msg(input[length] == '\0', "input has to be zero terminated");
+  return (char *)input;
+}
+
+// dayXX -> XX
+static inline uint32_t aoc_day_number(const aoc_day *const day) {
+  return strtoul(day->name + 3, NULL, 10);
+}
+
+// one line per part. day 1 always printed both parts on one line, so it still does
+static inline void aoc_print(FILE *f, const aoc_day *const day, const aoc_result *const result) {
+  if (aoc_day_number(day) == 1 && result->part_count > 1) {
+    fprintf(f, "%lu %lu\n", result->part1, result->part2);
+    return;
+  }
+  fprintf(f, "%lu\n", result->part1);
+  if (result->part_count > 1)
+    fprintf(f, "%lu\n", result->part2);
+}
+
+// runs both parts of a day, in parallel if the calling thread belongs to a pool. the parts time themselves with
+// bench_phase_begin/end, which only works on the thread the bench belongs to. so while benchmarking they run one after
+// the other on the calling thread
+static inline void aoc_fork_parts(void (*a)(void *), void *a_arg, void (*b)(void *), void *b_arg) {
+  if (bench_active) {
+    a(a_arg);
+    b(b_arg);
+    return;
+  }
+  pool_fork_join(a, a_arg, b, b_arg);
+}
+
+
+// c can be NULL or a disabled cache
+static inline void aoc_solve(const aoc_day *const day, void *const state, cache *const c, const char *const input,
+                             const size_t length, aoc_result *const result) {
+  if (!c || !cache_enabled(c)) {
+    day->solve(state, input, length, result);
+    return;
+  }
+  const uint64_t key = cache_key(c, aoc_day_number(day), input, length);
+  if (cache_lookup(c, key, &result->part1, &result->part2, &result->part_count))
+    return;
+  day->solve(state, input, length, result);
+  cache_insert(c, key, result->part1, result->part2, result->part_count);
+}
+
+// loads the file and solves it as often as the bench wants. a bench would only measure the cache, so don't pass one
+// while benchmarking
+static inline bool aoc_run(bench *const b, const char *const file_name, const aoc_day *const day, void *const state,
+                           cache *const c, aoc_result *const result) {
+  do {
+    bench_begin(b, BENCH_PHASE_LOAD);
+    fileutils_mapping input = {0};
+    if (!fileutils_map(file_name, &input))
+      return false;
+    bench_end(b, BENCH_PHASE_LOAD);
+
+    aoc_solve(day, state, c, input.data, input.length - 1, result);
+    fileutils_unmap(&input);
+  } while (bench_next(b));
+  return true;
+}
+
+static inline uint64_t aoc_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// solves one input after another with the same state. prints the file name and its parts per input and the throughput
+// of the whole batch to stderr. keeps going if an input can't be loaded
+static inline bool aoc_batch(const aoc_day *const day, void *const state, cache *const c,
+                             const char *const *const file_names, const uint32_t file_count) {
+  bool all_solved = true;
+  uint32_t solved = 0;
+  uint64_t bytes = 0;
+  char *line = NULL;
+  size_t line_capacity = 0;
+  const uint64_t start = aoc_now_ns();
+  for (uint32_t i = 0;; ++i) {
+    const char *file_name = NULL;
+    if (file_count > 0) {
+      if (i == file_count)
+        break;
+      file_name = file_names[i];
+    } else {
+      // one file name per line on stdin
+      const ssize_t n = getline(&line, &line_capacity, stdin);
+      if (n < 0)
+        break;
+      if (n > 0 && line[n - 1] == '\n')
+        line[n - 1] = '\0';
+      if (line[0] == '\0')
+        continue;
+      file_name = line;
+    }
+
+    fileutils_mapping input = {0};
+    if (!fileutils_map(file_name, &input)) {
+      all_solved = false;
+      continue;
+    }
+    aoc_result result = {0};
+    aoc_solve(day, state, c, input.data, input.length - 1, &result);
+    bytes += input.length - 1;
+    fileutils_unmap(&input);
+
+    printf("%s\n", file_name);
+    aoc_print(stdout, day, &result);
+    ++solved;
+  }
+  const uint64_t elapsed = aoc_now_ns() - start;
+  free(line);
+
+  const double seconds = elapsed / 1e9;
+  fprintf(stderr, "%u inputs, %.2f MB in %.2f ms: %.0f inputs/s, %.2f MB/s\n", solved, bytes / 1e6, elapsed / 1e6,
+          seconds > 0 ? solved / seconds : 0.0, seconds > 0 ? bytes / 1e6 / seconds : 0.0);
+  return all_solved;
+}
+
+// solves the snapshot as often as the bench wants. loading and validating it counts as the load phase
+static inline bool aoc_run_snapshot(bench *const b, const char *const file_name, const aoc_day *const day,
+                                    void *const state, aoc_result *const result) {
+  do {
+    if (!day->solve_snapshot(state, file_name, result))
+      return false;
+  } while (bench_next(b));
+  return true;
+}
+
+// parses the input and writes the parsed form to snapshot_name instead of solving it
+static inline bool aoc_emit_snapshot(const aoc_day *const day, void *const state, const char *const file_name,
+                                     const char *const snapshot_name) {
+  fileutils_mapping input = {0};
+  if (!fileutils_map(file_name, &input))
+    return false;
+  const bool written = day->emit_snapshot(state, input.data, input.length - 1, snapshot_name);
+  fileutils_unmap(&input);
+  return written;
+}
+
+//   dayXX [--bench <n>] [--bench-json <file>] [--counters] [cache options] <input>
+//   dayXX [cache options] --batch [<input> ...]   without inputs the file names are read from stdin, one per line
+//   dayXX --emit-snapshot <snapshot> <input>      parse only and write the parsed input (days 06, 10 and 11)
+//   dayXX [--bench <n>] ... --snapshot <snapshot> solve a snapshot without parsing
+//
+// the cache options are in cache.h. benchmarks always solve, they never use the cache. neither do snapshots, the cache
+// is keyed on the input text
+static inline int aoc_main(int argc, char **argv, const aoc_day *const day) {
+  bench b = {0};
+  cache_options co = {0};
+  if (!bench_init(&b, day->name, &argc, argv))
+    return 1;
+  if (!cache_parse_options(&co, &argc, argv)) {
+    bench_destroy(&b);
+    return 1;
+  }
+
+  const char *emit_snapshot = NULL;
+  const char *from_snapshot = NULL;
+  uint32_t thread_count = 1;
+  bool batch = false;
+  bool simd_valid = true;
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      thread_count = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--emit-snapshot") == 0 && i + 1 < argc)
+      emit_snapshot = argv[++i];
+    else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+      from_snapshot = argv[++i];
+    else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+      simd_valid &= dispatch_force(argv[++i]);
+    else if (strcmp(argv[i], "--batch") == 0 && out == 1)
+      batch = true;
+    else
+      argv[out++] = argv[i];
+  }
+  argc = out;
+
+  const char *error = NULL;
+  char thread_error[64];
+  snprintf(thread_error, sizeof(thread_error), "--threads needs between 1 and %u threads", POOL_MAX_THREADS);
+  if (!simd_valid)
+    error = "--simd needs one of scalar, sse4.2, avx2 or avx512";
+  else if ((emit_snapshot || from_snapshot) && !day->solve_snapshot)
+    error = "snapshots aren't supported by this day";
+  else if (batch && (b.enabled || emit_snapshot || from_snapshot))
+    error = "--batch doesn't work together with the bench or snapshot options";
+  else if (emit_snapshot && (b.enabled || from_snapshot))
+    error = "--emit-snapshot doesn't work together with the bench options or --snapshot";
+  else if (thread_count == 0 || thread_count > POOL_MAX_THREADS)
+    error = thread_error;
+  if (error)
+    fprintf(stderr, "%s\n", error);
+  else if (!batch && argc != (from_snapshot ? 1 : 2)) {
+    fprintf(stderr, "usage: %s [bench options] [--threads <n>] [cache options] <input>\n", argv[0]);
+    fprintf(stderr, "       %s [--threads <n>] [cache options] --batch [<input> ...]\n", argv[0]);
+    fprintf(stderr, "       %s --emit-snapshot <snapshot> <input>\n", argv[0]);
+    fprintf(stderr, "       %s [bench options] [--threads <n>] --snapshot <snapshot>\n", argv[0]);
+    fprintf(stderr, "bench options: --bench <n>, --bench-json <file>, --counters, --trace <file>, --simd <level>\n");
+    fprintf(stderr, "cache options: --cache, --no-cache, --cache-dir <dir>, --cache-entries <n>, --cache-stats\n");
+    error = "usage";
+  }
+  if (error) {
+    bench_destroy(&b);
+    return 1;
+  }
+
+  // the days split their loops over the pool with pool_parallel_for. without one they run serially
+  pool p = {0};
+  if (thread_count > 1 && !pool_create(&p, thread_count - 1)) {
+    fprintf(stderr, "couldn't create a pool with %u threads\n", thread_count);
+    bench_destroy(&b);
+    return 1;
+  }
+
+  cache c = {0};
+  co.disabled |= b.enabled || emit_snapshot || from_snapshot || COUNTERS_ENABLED;
+  cache_open(&c, &co);
+
+  void *const state = day->create();
+  aoc_result result = {0};
+  bool solved;
+  if (batch) {
+    solved = aoc_batch(day, state, &c, (const char *const *)&argv[1], argc - 1);
+  } else if (emit_snapshot) {
+    solved = aoc_emit_snapshot(day, state, argv[1], emit_snapshot);
+  } else {
+    solved = from_snapshot ? aoc_run_snapshot(&b, from_snapshot, day, state, &result)
+                           : aoc_run(&b, argv[1], day, state, &c, &result);
+    if (solved) {
+      aoc_print(stdout, day, &result);
+      bench_report(&b);
+    }
+  }
+  if (co.stats)
+    cache_print_stats(&c, stderr);
+  day->destroy(state);
+  cache_close(&c);
+  if (thread_count > 1)
+    pool_destroy(&p);
+  bench_destroy(&b);
+  return solved ? 0 : 1;
+}
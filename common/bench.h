@@ -0,0 +1,387 @@
+#pragma once
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dispatch.h"
+#include "memory.h"
+#include "perfcounters.h"
+#include "scratch.h"
+#include "trace.h"
+
+// per phase timing harness. every day runs its whole pipeline in a loop driven by bench_next. without `--bench` the
+// loop runs exactly once and nothing gets reported.
+//
+//   --bench <n>          run everything n times and print min/median/p99 per phase to stderr
+//   --bench-json <file>  additionally write the results as json
+//   --counters           also read hardware counters (cycles, instructions, cache, branch and dtlb misses) around every
+//                        phase
+//   --trace <file>       write every phase and section as it happened for perfetto (see trace.h)
+//
+// the solvers time their phases with bench_phase_begin/end and can add sections of their own with
+// bench_section_begin/end. those don't need the bench instance passed around and don't do anything unless benchmarking
+// is enabled. phases which allocate from a scratch (see scratch.h) also get their allocations reported
+//
+// the phase state and the hardware counters belong to the thread which created the bench, so phases and sections have
+// to begin and end on it. with --threads the parallel loops inside a phase still spread over the pool, but the
+// counters only see the work of the calling thread
+
+typedef enum bench_phase {
+  BENCH_PHASE_LOAD,
+  BENCH_PHASE_PARSE,
+  BENCH_PHASE_PART1,
+  BENCH_PHASE_PART2,
+  BENCH_PHASE_SOLVE, // for days which calculate both parts at once
+  BENCH_PHASE_COUNT,
+} bench_phase;
+
+// fixed phases plus sections
+#define BENCH_MAX_PHASES 16
+
+static const char *const bench_phase_names[BENCH_PHASE_COUNT] = {
+    [BENCH_PHASE_LOAD] = "load",   [BENCH_PHASE_PARSE] = "parse", [BENCH_PHASE_PART1] = "part1",
+    [BENCH_PHASE_PART2] = "part2", [BENCH_PHASE_SOLVE] = "solve",
+};
+
+typedef struct bench_phase_data {
+  const char *name;
+  bool used;
+  uint64_t start;
+  uint64_t *samples; // nanoseconds per iteration
+  uint64_t entries;  // how often the phase was entered over all iterations
+  perf_values counters_start;
+  perf_values counters_total;
+  // scratch.h accounting. the high water mark is of everything in use while the phase ran, not just its own part
+  uint64_t scratch_allocated_start;
+  uint64_t scratch_chunks_start;
+  uint64_t scratch_outer_high_water; // of the enclosing phase, restored at the end
+  uint64_t scratch_allocated;        // over all iterations
+  uint64_t scratch_chunks;           // over all iterations
+  uint64_t scratch_high_water;
+} bench_phase_data;
+
+typedef struct bench_options {
+  const char *json_file;
+  const char *trace_file;
+  uint32_t iterations;
+  bool enabled;
+  bool counters;
+} bench_options;
+
+typedef struct bench {
+  const char *name;
+  const char *json_file;
+  const char *trace_file;
+  trace trace;
+  uint32_t iterations;
+  uint32_t iteration;
+  bool enabled;
+  bool counters_requested;
+  perf_counters counters;
+  uint32_t phase_count;
+  bench_phase_data phases[BENCH_MAX_PHASES];
+  uint64_t iteration_start;
+  uint64_t *totals; // whole iteration, including the work between the phases
+} bench;
+
+typedef struct bench_stats {
+  uint64_t min;
+  uint64_t median;
+  uint64_t p99;
+} bench_stats;
+
+// the instance the sections report to. only set while benchmarking. weak so all translation units of the aoc runner
+// share the same one
+__attribute__((weak)) bench *bench_active = NULL;
+
+static inline uint64_t bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// removes the options from argv so the days can keep checking argc as before
+static inline bool bench_parse_options(bench_options *const o, int *const argc, char **argv) {
+  *o = (bench_options){.iterations = 1};
+
+  int out = 1;
+  for (int i = 1; i < *argc; ++i) {
+    if (strcmp(argv[i], "--bench") == 0 && i + 1 < *argc) {
+      o->iterations = strtoul(argv[++i], NULL, 10);
+      o->enabled = true;
+    } else if (strcmp(argv[i], "--bench-json") == 0 && i + 1 < *argc) {
+      o->json_file = argv[++i];
+      o->enabled = true;
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < *argc) {
+      o->trace_file = argv[++i];
+      o->enabled = true;
+    } else if (strcmp(argv[i], "--counters") == 0) {
+      o->counters = true;
+      o->enabled = true;
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  *argc = out;
+
+  if (o->iterations == 0) {
+    fprintf(stderr, "--bench needs at least one iteration\n");
+    return false;
+  }
+  return true;
+}
+
+static inline void bench_create(bench *const b, const char *name, const bench_options *const o) {
+  *b = (bench){.name = name,
+               .json_file = o->json_file,
+               .trace_file = o->trace_file,
+               .iterations = o->iterations,
+               .enabled = o->enabled,
+               .counters_requested = o->counters};
+
+  for (uint32_t i = 0; i < BENCH_PHASE_COUNT; ++i) {
+    b->phases[i].name = bench_phase_names[i];
+    b->phases[i].samples = calloc(b->iterations, sizeof(uint64_t));
+  }
+  b->phase_count = BENCH_PHASE_COUNT;
+  b->totals = calloc(b->iterations, sizeof(uint64_t));
+
+  if (b->counters_requested && !perf_counters_open(&b->counters))
+    fprintf(stderr, "hardware counters unavailable (%s). only timing %s\n", strerror(errno), name);
+
+  if (b->enabled)
+    bench_active = b;
+  if (b->trace_file) {
+    trace_create(&b->trace, 0);
+    trace_active = &b->trace;
+  }
+  b->iteration_start = bench_now();
+}
+
+static inline bool bench_init(bench *const b, const char *name, int *const argc, char **argv) {
+  bench_options o = {0};
+  if (!bench_parse_options(&o, argc, argv))
+    return false;
+  bench_create(b, name, &o);
+  return true;
+}
+
+static inline void bench_destroy(bench *const b) {
+  for (uint32_t i = 0; i < b->phase_count; ++i)
+    free(b->phases[i].samples);
+  free(b->totals);
+  perf_counters_close(&b->counters);
+  if (b->trace_file)
+    trace_destroy(&b->trace);
+  if (bench_active == b)
+    bench_active = NULL;
+}
+
+static inline void bench_begin(bench *const b, const uint32_t phase) {
+  bench_phase_data *const p = &b->phases[phase];
+  p->scratch_allocated_start = atomic_load_explicit(&scratch_totals.allocated, memory_order_relaxed);
+  p->scratch_chunks_start = atomic_load_explicit(&scratch_totals.chunks, memory_order_relaxed);
+  p->scratch_outer_high_water = atomic_exchange_explicit(
+      &scratch_totals.high_water, atomic_load_explicit(&scratch_totals.in_use, memory_order_relaxed),
+      memory_order_relaxed);
+  if (b->counters.active_count > 0)
+    perf_counters_read(&b->counters, &p->counters_start);
+  p->start = bench_now();
+}
+
+// adds up if a phase is entered multiple times per iteration (like parsing chunk by chunk)
+static inline void bench_end(bench *const b, const uint32_t phase) {
+  bench_phase_data *const p = &b->phases[phase];
+  const uint64_t now = bench_now();
+  p->samples[b->iteration] += now - p->start;
+  if (b->trace_file)
+    trace_record(&b->trace, p->name, phase < BENCH_PHASE_COUNT ? "phase" : "section", p->start, now);
+  p->entries++;
+  p->used = true;
+  const uint64_t high_water = atomic_load_explicit(&scratch_totals.high_water, memory_order_relaxed);
+  p->scratch_allocated +=
+      atomic_load_explicit(&scratch_totals.allocated, memory_order_relaxed) - p->scratch_allocated_start;
+  p->scratch_chunks += atomic_load_explicit(&scratch_totals.chunks, memory_order_relaxed) - p->scratch_chunks_start;
+  if (high_water > p->scratch_high_water)
+    p->scratch_high_water = high_water;
+  scratch_raise_high_water(p->scratch_outer_high_water);
+  if (b->counters.active_count > 0) {
+    perf_values now;
+    perf_counters_read(&b->counters, &now);
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i)
+      p->counters_total.values[i] += now.values[i] - p->counters_start.values[i];
+  }
+}
+
+// for code which doesn't get the bench instance passed, like the dayXX_solve functions
+static inline void bench_phase_begin(const bench_phase phase) {
+  if (bench_active)
+    bench_begin(bench_active, phase);
+}
+
+static inline void bench_phase_end(const bench_phase phase) {
+  if (bench_active)
+    bench_end(bench_active, phase);
+}
+
+// sections are identified by their name. pass string literals, they are compared by address first
+static inline uint32_t bench_section_id(bench *const b, const char *name) {
+  for (uint32_t i = BENCH_PHASE_COUNT; i < b->phase_count; ++i) {
+    if (b->phases[i].name == name || strcmp(b->phases[i].name, name) == 0)
+      return i;
+  }
+  if (b->phase_count == BENCH_MAX_PHASES) {
+    fprintf(stderr, "too many bench sections. max: %u\n", BENCH_MAX_PHASES - BENCH_PHASE_COUNT);
+    exit(1);
+  }
+  const uint32_t id = b->phase_count++;
+  b->phases[id].name = name;
+  b->phases[id].samples = calloc(b->iterations, sizeof(uint64_t));
+  return id;
+}
+
+static inline void bench_section_begin(const char *name) {
+  if (bench_active)
+    bench_begin(bench_active, bench_section_id(bench_active, name));
+}
+
+static inline void bench_section_end(const char *name) {
+  if (bench_active)
+    bench_end(bench_active, bench_section_id(bench_active, name));
+}
+
+// call at the end of every iteration. returns true as long as there are iterations left
+static inline bool bench_next(bench *const b) {
+  const uint64_t now = bench_now();
+  b->totals[b->iteration] = now - b->iteration_start;
+  if (b->trace_file)
+    trace_record(&b->trace, "iteration", "iteration", b->iteration_start, now);
+  b->iteration_start = now;
+  return ++b->iteration < b->iterations;
+}
+
+static inline int bench_u64_compare(const void *left, const void *right) {
+  const uint64_t l = *(const uint64_t *)left;
+  const uint64_t r = *(const uint64_t *)right;
+  return (l > r) - (l < r);
+}
+
+static inline bench_stats bench_sample_stats(const uint64_t *const samples, const uint32_t n) {
+  uint64_t *sorted = malloc(sizeof(uint64_t) * n);
+  memcpy(sorted, samples, sizeof(uint64_t) * n);
+  qsort(sorted, n, sizeof(uint64_t), bench_u64_compare);
+  const uint32_t p99_index = (n * 99 + 99) / 100 - 1; // ceil(n * 0.99) - 1
+  const bench_stats stats = {.min = sorted[0], .median = sorted[n / 2], .p99 = sorted[p99_index]};
+  free(sorted);
+  return stats;
+}
+
+static inline bench_stats bench_phase_stats(const bench *const b, const uint32_t phase) {
+  return bench_sample_stats(b->phases[phase].samples, b->iterations);
+}
+
+// average per iteration
+static inline double bench_counter(const bench *const b, const uint32_t phase, const perf_counter counter) {
+  return (double)b->phases[phase].counters_total.values[counter] / b->iterations;
+}
+
+static inline void bench_write_json(const bench *const b, FILE *f) {
+  const bench_stats total = bench_sample_stats(b->totals, b->iterations);
+  fprintf(f, "{\"name\":\"%s\",\"iterations\":%u,\"huge_pages\":\"%s\",\"simd\":\"%s\",", b->name, b->iterations,
+          memory_huge_pages_names[memory_huge_pages_mode()], dispatch_level_names[dispatch_selected()]);
+  fprintf(f, "\"total\":{\"min_ns\":%lu,\"median_ns\":%lu,\"p99_ns\":%lu},\"phases\":{", total.min, total.median,
+          total.p99);
+  bool first = true;
+  for (uint32_t i = 0; i < b->phase_count; ++i) {
+    const bench_phase_data *const p = &b->phases[i];
+    if (!p->used)
+      continue;
+    const bench_stats s = bench_phase_stats(b, i);
+    fprintf(f, "%s\"%s\":{\"min_ns\":%lu,\"median_ns\":%lu,\"p99_ns\":%lu,\"calls_per_iteration\":%.2f", first ? "" : ",",
+            p->name, s.min, s.median, s.p99, (double)p->entries / b->iterations);
+    if (b->counters.active_count > 0) {
+      fprintf(f, ",\"counters\":{");
+      bool first_counter = true;
+      for (uint32_t c = 0; c < PERF_COUNTER_COUNT; ++c) {
+        if (!b->counters.available[c])
+          continue;
+        fprintf(f, "%s\"%s\":%.0f", first_counter ? "" : ",", perf_counter_names[c], bench_counter(b, i, c));
+        first_counter = false;
+      }
+      fprintf(f, "}");
+    }
+    if (p->scratch_high_water > 0)
+      fprintf(f, ",\"scratch\":{\"bytes_per_iteration\":%.0f,\"chunks\":%lu,\"high_water_bytes\":%lu}",
+              (double)p->scratch_allocated / b->iterations, p->scratch_chunks, p->scratch_high_water);
+    fprintf(f, "}");
+    first = false;
+  }
+  fprintf(f, "}}\n");
+}
+
+static inline void bench_report(const bench *const b) {
+  if (!b->enabled)
+    return;
+
+  fprintf(stderr, "%s (%u iterations, huge pages: %s, simd: %s)\n", b->name, b->iterations,
+          memory_huge_pages_names[memory_huge_pages_mode()], dispatch_level_names[dispatch_selected()]);
+  fprintf(stderr, "  %-16s %12s %12s %12s %8s\n", "phase", "min us", "median us", "p99 us", "calls");
+  for (uint32_t i = 0; i < b->phase_count; ++i) {
+    if (!b->phases[i].used)
+      continue;
+    const bench_stats s = bench_phase_stats(b, i);
+    fprintf(stderr, "  %-16s %12.2f %12.2f %12.2f %8.1f\n", b->phases[i].name, s.min / 1000.0, s.median / 1000.0,
+            s.p99 / 1000.0, (double)b->phases[i].entries / b->iterations);
+  }
+  const bench_stats total = bench_sample_stats(b->totals, b->iterations);
+  fprintf(stderr, "  %-16s %12.2f %12.2f %12.2f\n", "total", total.min / 1000.0, total.median / 1000.0,
+          total.p99 / 1000.0);
+
+  if (b->counters.active_count > 0) {
+    // per iteration averages. unsupported counters show up as 0
+    fprintf(stderr, "  %-16s %14s %14s %6s %12s %12s %12s %12s\n", "phase", "cycles", "instructions", "ipc",
+            "l1d misses", "llc misses", "br misses", "dtlb misses");
+    for (uint32_t i = 0; i < b->phase_count; ++i) {
+      if (!b->phases[i].used)
+        continue;
+      const double cycles = bench_counter(b, i, PERF_COUNTER_CYCLES);
+      const double instructions = bench_counter(b, i, PERF_COUNTER_INSTRUCTIONS);
+      fprintf(stderr, "  %-16s %14.0f %14.0f %6.2f %12.0f %12.0f %12.0f %12.0f\n", b->phases[i].name, cycles,
+              instructions, cycles > 0 ? instructions / cycles : 0.0, bench_counter(b, i, PERF_COUNTER_L1D_MISSES),
+              bench_counter(b, i, PERF_COUNTER_LLC_MISSES), bench_counter(b, i, PERF_COUNTER_BRANCH_MISSES),
+              bench_counter(b, i, PERF_COUNTER_DTLB_MISSES));
+    }
+  }
+
+  bool scratch_used = false;
+  for (uint32_t i = 0; i < b->phase_count; ++i)
+    scratch_used |= b->phases[i].used && b->phases[i].scratch_high_water > 0;
+  if (scratch_used) {
+    // chunks are summed over all iterations. only the first one should have to add any
+    fprintf(stderr, "  %-16s %14s %12s %14s\n", "scratch", "KB/iteration", "new chunks", "high water KB");
+    for (uint32_t i = 0; i < b->phase_count; ++i) {
+      const bench_phase_data *const p = &b->phases[i];
+      if (!p->used || p->scratch_high_water == 0)
+        continue;
+      fprintf(stderr, "  %-16s %14.2f %12lu %14.2f\n", p->name, p->scratch_allocated / 1024.0 / b->iterations,
+              p->scratch_chunks, p->scratch_high_water / 1024.0);
+    }
+  }
+
+  if (b->trace_file)
+    trace_write(&b->trace, b->trace_file, b->name);
+  if (b->json_file) {
+    FILE *f = fopen(b->json_file, "w");
+    if (!f) {
+      fprintf(stderr, "couldn't open file '%s'\n", b->json_file);
+      return;
+    }
+    bench_write_json(b, f);
+    fclose(f);
+  }
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <link.h> // dl_iterate_phdr needs _GNU_SOURCE, the makefile defines it
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fileutils.h"
+#include "hash.h"
+
+// on-disk result cache. the key is the xxh64 of the input, seeded with the build id of the binary and the day, so a
+// rebuilt solver never sees answers of an older one. the whole cache is one file which gets mapped: a header and a
+// fixed number of 8-way sets. a lookup hashes the input and reads one set, no parsing, no solving
+//
+// replacement is lru within a set (the header has a clock which every hit and insert bumps), so the file never grows.
+// the size limit is the entry count the file was created with. a different --cache-entries recreates it
+//
+// several processes can share the file. every access holds flock on it and threads of one process share a mutex on
+// top, since flock doesn't exclude threads which use the same descriptor
+//
+// the cache is off unless asked for. it writes a file outside of the repo and a hit skips the solver, which is not what
+// you want while working on one
+//
+//   --cache                look up and store results. AOC_CACHE=1 in the environment does the same
+//   --no-cache             don't look up or store anything, even with AOC_CACHE=1
+//   --cache-dir <dir>      where the cache file lives (default $AOC_CACHE_DIR, $XDG_CACHE_HOME/aoc or ~/.cache/aoc)
+//   --cache-entries <n>    size limit, rounded up to a multiple of 8 (default 65536, ~3MB)
+//   --cache-stats          print the hit/miss statistics to stderr at the end
+
+#define CACHE_MAGIC 0x3165686361636f61ull // "aocache1"
+#define CACHE_WAYS 8
+#define CACHE_DEFAULT_ENTRIES 65536
+#define CACHE_MAX_PATH 512
+
+typedef struct cache_entry {
+  uint64_t key; // 0 = empty
+  uint64_t last_used;
+  uint64_t part1;
+  uint64_t part2;
+  uint32_t part_count;
+  uint32_t check; // catches an entry which was only half written when a process died
+} cache_entry;
+
+typedef struct cache_header {
+  uint64_t magic;
+  uint64_t set_count;
+  uint64_t clock;
+  // statistics over the lifetime of the file
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t inserts;
+  uint64_t evictions;
+  uint64_t padding;
+} cache_header;
+
+typedef struct cache_options {
+  const char *dir;
+  uint64_t entries;
+  bool disabled;
+  bool stats;
+} cache_options;
+
+typedef struct cache {
+  int fd;
+  cache_header *header;
+  cache_entry *entries;
+  size_t mapped_size;
+  uint64_t seed;
+  pthread_mutex_t mutex;
+  // this process only
+  uint64_t hits;
+  uint64_t misses;
+} cache;
+
+// removes the options from argv, like bench_parse_options
+static inline bool cache_parse_options(cache_options *const o, int *const argc, char **argv) {
+  const char *const env = getenv("AOC_CACHE");
+  *o = (cache_options){.entries = CACHE_DEFAULT_ENTRIES, .disabled = !env || strcmp(env, "1") != 0};
+
+  int out = 1;
+  for (int i = 1; i < *argc; ++i) {
+    if (strcmp(argv[i], "--cache") == 0) {
+      o->disabled = false;
+    } else if (strcmp(argv[i], "--no-cache") == 0) {
+      o->disabled = true;
+    } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < *argc) {
+      o->dir = argv[++i];
+    } else if (strcmp(argv[i], "--cache-entries") == 0 && i + 1 < *argc) {
+      o->entries = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--cache-stats") == 0) {
+      o->stats = true;
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  *argc = out;
+
+  if (o->entries == 0) {
+    fprintf(stderr, "--cache-entries needs at least one entry\n");
+    return false;
+  }
+  return true;
+}
+
+static inline int cache_build_id_note(struct dl_phdr_info *info, size_t size, void *data) {
+  (void)size;
+  uint64_t *const seed = data;
+  for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr) *const ph = &info->dlpi_phdr[i];
+    if (ph->p_type != PT_NOTE)
+      continue;
+    const char *note = (const char *)(info->dlpi_addr + ph->p_vaddr);
+    const char *const end = note + ph->p_memsz;
+    while (note + sizeof(ElfW(Nhdr)) <= end) {
+      const ElfW(Nhdr) *const n = (const ElfW(Nhdr) *)note;
+      const char *const name = note + sizeof(ElfW(Nhdr));
+      const char *const desc = name + ((n->n_namesz + 3) & ~3u);
+      if (n->n_type == NT_GNU_BUILD_ID && n->n_namesz == 4 && memcmp(name, "GNU", 4) == 0) {
+        *seed = hash_xxh64(desc, n->n_descsz, 0);
+        return 1;
+      }
+      note = desc + ((n->n_descsz + 3) & ~3u);
+    }
+  }
+  return 1; // the first object is the executable itself. the libraries don't matter
+}
+
+// the gnu build id the linker put into the executable. without one the whole executable gets hashed
+static inline uint64_t cache_build_id(void) {
+  uint64_t seed = 0;
+  dl_iterate_phdr(cache_build_id_note, &seed);
+  if (seed != 0)
+    return seed;
+
+  fileutils_mapping exe = {0};
+  if (fileutils_map("/proc/self/exe", &exe)) {
+    seed = hash_xxh64(exe.data, exe.length, 0);
+    fileutils_unmap(&exe);
+  }
+  return seed;
+}
+
+static inline uint32_t cache_entry_check(const cache_entry *const e) {
+  const uint64_t h = hash_round(hash_round(hash_round(e->key, e->part1), e->part2), e->part_count);
+  return (uint32_t)(h ^ (h >> 32));
+}
+
+static inline bool cache_path(const cache_options *const o, char *const path) {
+  const char *dir = o->dir ? o->dir : getenv("AOC_CACHE_DIR");
+  char default_dir[CACHE_MAX_PATH];
+  if (!dir) {
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (xdg && *xdg)
+      snprintf(default_dir, sizeof(default_dir), "%s/aoc", xdg);
+    else if (home && *home)
+      snprintf(default_dir, sizeof(default_dir), "%s/.cache/aoc", home);
+    else
+      return false;
+    dir = default_dir;
+    // ~/.cache might not exist yet either
+    char parent[CACHE_MAX_PATH];
+    snprintf(parent, sizeof(parent), "%s", dir);
+    *strrchr(parent, '/') = '\0';
+    mkdir(parent, 0755);
+  }
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    return false;
+  return snprintf(path, CACHE_MAX_PATH, "%s/results.bin", dir) < CACHE_MAX_PATH;
+}
+
+// a new file replaces the old one by rename, so processes which still have the old one mapped aren't affected
+static inline int cache_create_file(const char *const path, const uint64_t set_count, const size_t size) {
+  char tmp_path[CACHE_MAX_PATH + 16];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+  const int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return -1;
+  const cache_header fresh = {.magic = CACHE_MAGIC, .set_count = set_count};
+  if (ftruncate(fd, size) != 0 || pwrite(fd, &fresh, sizeof(fresh), 0) != sizeof(fresh) ||
+      rename(tmp_path, path) != 0) {
+    close(fd);
+    unlink(tmp_path);
+    return -1;
+  }
+  return fd;
+}
+
+// a cache which can't be opened is just disabled. the days work the same without it
+static inline void cache_open(cache *const c, const cache_options *const o) {
+  *c = (cache){.fd = -1};
+  pthread_mutex_init(&c->mutex, NULL);
+  char path[CACHE_MAX_PATH];
+  if (o->disabled || !cache_path(o, path))
+    return;
+
+  const uint64_t set_count = (o->entries + CACHE_WAYS - 1) / CACHE_WAYS;
+  const size_t size = sizeof(cache_header) + set_count * CACHE_WAYS * sizeof(cache_entry);
+  c->fd = open(path, O_RDWR);
+  struct stat st = {0};
+  cache_header existing = {0};
+  const bool valid = c->fd >= 0 && fstat(c->fd, &st) == 0 && (size_t)st.st_size == size &&
+                     pread(c->fd, &existing, sizeof(existing), 0) == sizeof(existing) &&
+                     existing.magic == CACHE_MAGIC && existing.set_count == set_count;
+  if (!valid) {
+    // new, from an older format or with another size. start over
+    if (c->fd >= 0)
+      close(c->fd);
+    c->fd = cache_create_file(path, set_count, size);
+    if (c->fd < 0) {
+      fprintf(stderr, "couldn't create cache '%s': %s. not caching\n", path, strerror(errno));
+      return;
+    }
+  }
+
+  void *const data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, c->fd, 0);
+  if (data == MAP_FAILED) {
+    close(c->fd);
+    c->fd = -1;
+    return;
+  }
+  c->mapped_size = size;
+  c->header = data;
+  c->entries = (cache_entry *)(c->header + 1);
+  c->seed = cache_build_id();
+}
+
+static inline void cache_close(cache *const c) {
+  if (c->header)
+    munmap(c->header, c->mapped_size);
+  if (c->fd >= 0)
+    close(c->fd);
+  pthread_mutex_destroy(&c->mutex);
+  *c = (cache){.fd = -1};
+}
+
+static inline bool cache_enabled(const cache *const c) {
+  return c->header != NULL;
+}
+
+static inline uint64_t cache_key(const cache *const c, const uint32_t day, const char *const input,
+                                 const size_t length) {
+  const uint64_t key = hash_xxh64(input, length, c->seed ^ (day * HASH_PRIME64_3));
+  return key == 0 ? 1 : key;
+}
+
+static inline void cache_lock(cache *const c) {
+  pthread_mutex_lock(&c->mutex);
+  flock(c->fd, LOCK_EX);
+}
+
+static inline void cache_unlock(cache *const c) {
+  flock(c->fd, LOCK_UN);
+  pthread_mutex_unlock(&c->mutex);
+}
+
+static inline bool cache_lookup(cache *const c, const uint64_t key, uint64_t *const part1, uint64_t *const part2,
+                                uint8_t *const part_count) {
+  cache_lock(c);
+  cache_entry *const set = &c->entries[(key % c->header->set_count) * CACHE_WAYS];
+  bool hit = false;
+  for (uint32_t i = 0; i < CACHE_WAYS; ++i) {
+    cache_entry *const e = &set[i];
+    if (e->key == key && e->check == cache_entry_check(e)) {
+      e->last_used = ++c->header->clock;
+      *part1 = e->part1;
+      *part2 = e->part2;
+      *part_count = e->part_count;
+      hit = true;
+      break;
+    }
+  }
+  if (hit) {
+    c->header->hits++;
+    c->hits++;
+  } else {
+    c->header->misses++;
+    c->misses++;
+  }
+  cache_unlock(c);
+  return hit;
+}
+
+static inline void cache_insert(cache *const c, const uint64_t key, const uint64_t part1, const uint64_t part2,
+                                const uint8_t part_count) {
+  cache_lock(c);
+  cache_entry *const set = &c->entries[(key % c->header->set_count) * CACHE_WAYS];
+  // the same key if another process was faster, else an empty slot, else the least recently used one
+  cache_entry *victim = &set[0];
+  for (uint32_t i = 0; i < CACHE_WAYS; ++i) {
+    if (set[i].key == key || set[i].key == 0) {
+      victim = &set[i];
+      break;
+    }
+    if (set[i].last_used < victim->last_used)
+      victim = &set[i];
+  }
+  if (victim->key != 0 && victim->key != key)
+    c->header->evictions++;
+  *victim = (cache_entry){
+      .key = key, .last_used = ++c->header->clock, .part1 = part1, .part2 = part2, .part_count = part_count};
+  victim->check = cache_entry_check(victim);
+  c->header->inserts++;
+  cache_unlock(c);
+}
+
+static inline void cache_print_stats(cache *const c, FILE *f) {
+  if (!cache_enabled(c)) {
+    fprintf(f, "cache: disabled\n");
+    return;
+  }
+  cache_lock(c);
+  const uint64_t capacity = c->header->set_count * CACHE_WAYS;
+  uint64_t used = 0;
+  for (uint64_t i = 0; i < capacity; ++i)
+    used += c->entries[i].key != 0;
+  fprintf(f, "cache: %lu hits, %lu misses in this run. total %lu hits, %lu misses, %lu inserts, %lu evictions\n",
+          c->hits, c->misses, c->header->hits, c->header->misses, c->header->inserts, c->header->evictions);
+  fprintf(f, "cache: %lu of %lu entries used (%.1f%%)\n", used, capacity, 100.0 * used / capacity);
+  cache_unlock(c);
+}
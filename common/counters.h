@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// counts of the work a solver does, like hashmap probes or recursive calls. unlike timings they don't depend on the
+// machine or on what else runs on it, so they show how the work grows with the input
+//
+//   make counters=1   builds with AOC_COUNTERS. without it the macros expand to nothing and cost nothing
+//
+// a day declares its counters at file scope and bumps them in the hot paths. both work in expressions, so they fit into
+// TLBT_EQUALS_FUNC and friends:
+//
+//   AOC_COUNTER(probes, "day07 hashmap probes")
+//   AOC_COUNTER_MAX(depth, "day03 find_joltage max depth")
+//   AOC_COUNT(probes); AOC_COUNT_ADD(probes, n); AOC_COUNT_MAX(depth, d);
+//
+// every thread counts into its own block, so the pool workers don't fight over cache lines. the blocks are summed up
+// (or maxed) and printed to stderr when the process exits, together with the share of every thread if more than one
+// counted. the counts add up over all iterations of --bench and all inputs of --batch. the cache stays off in this
+// build, a cache hit would count nothing
+
+#ifdef AOC_COUNTERS
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ext/toolbelt/src/assert.h"
+
+#define COUNTERS_ENABLED 1
+#define COUNTERS_MAX 64
+
+typedef enum counter_kind {
+  COUNTER_SUM,
+  COUNTER_MAX,
+} counter_kind;
+
+typedef struct counter {
+  const char *name;
+  counter_kind kind;
+  _Atomic uint32_t slot; // in the blocks, + 1. 0 until the first count
+} counter;
+
+typedef struct counters_block {
+  struct counters_block *next;
+  uint32_t thread; // in the order the threads started counting
+  uint64_t values[COUNTERS_MAX];
+} counters_block;
+
+typedef struct counters_registry {
+  pthread_mutex_t lock;
+  uint32_t count;
+  const char *names[COUNTERS_MAX];
+  counter_kind kinds[COUNTERS_MAX];
+  counters_block *blocks; // oldest first. never freed, the totals are printed after the threads are gone
+  counters_block **last;
+  uint32_t block_count;
+} counters_registry;
+
+// weak so all translation units of the aoc runner share them. counters with the same name are merged
+__attribute__((weak)) counters_registry counters_all = {.lock = PTHREAD_MUTEX_INITIALIZER};
+__attribute__((weak)) _Thread_local counters_block *counters_self = NULL;
+
+static inline void counters_dump(void) {
+  pthread_mutex_lock(&counters_all.lock);
+  fprintf(stderr, "counters (%u %s)\n", counters_all.block_count, counters_all.block_count == 1 ? "thread" : "threads");
+  for (uint32_t i = 0; i < counters_all.count; ++i) {
+    uint64_t total = 0;
+    uint32_t threads = 0;
+    for (const counters_block *b = counters_all.blocks; b; b = b->next) {
+      const uint64_t v = b->values[i];
+      total = counters_all.kinds[i] == COUNTER_MAX ? (v > total ? v : total) : total + v;
+      threads += v != 0;
+    }
+    fprintf(stderr, "  %-40s %16lu\n", counters_all.names[i], total);
+    if (threads < 2)
+      continue;
+    for (const counters_block *b = counters_all.blocks; b; b = b->next) {
+      if (b->values[i] != 0)
+        fprintf(stderr, "    thread %-31u %16lu\n", b->thread, b->values[i]);
+    }
+  }
+  pthread_mutex_unlock(&counters_all.lock);
+}
+
+static inline uint32_t counters_register(counter *const c) {
+  pthread_mutex_lock(&counters_all.lock);
+  uint32_t slot = 0;
+  while (slot < counters_all.count && strcmp(counters_all.names[slot], c->name) != 0)
+    ++slot;
+  if (slot == counters_all.count) {
+    tlbt_assert_fmt(slot < COUNTERS_MAX, "too many counters. max: %u", COUNTERS_MAX);
+    if (slot == 0)
+      atexit(counters_dump);
+    counters_all.names[slot] = c->name;
+    counters_all.kinds[slot] = c->kind;
+    counters_all.count++;
+  }
+  pthread_mutex_unlock(&counters_all.lock);
+  atomic_store_explicit(&c->slot, slot + 1, memory_order_relaxed);
+  return slot;
+}
+
+static inline counters_block *counters_block_create(void) {
+  counters_block *const b = calloc(1, sizeof(counters_block));
+  tlbt_assert_msg(b != NULL, "couldn't allocate counters");
+  pthread_mutex_lock(&counters_all.lock);
+  if (!counters_all.last)
+    counters_all.last = &counters_all.blocks;
+  b->thread = counters_all.block_count++;
+  *counters_all.last = b;
+  counters_all.last = &b->next;
+  pthread_mutex_unlock(&counters_all.lock);
+  counters_self = b;
+  return b;
+}
+
+static inline uint64_t *counters_value(counter *const c) {
+  uint32_t slot = atomic_load_explicit(&c->slot, memory_order_relaxed);
+  slot = slot ? slot - 1 : counters_register(c);
+  counters_block *const b = counters_self ? counters_self : counters_block_create();
+  return &b->values[slot];
+}
+
+static inline void counters_add(counter *const c, const uint64_t n) {
+  *counters_value(c) += n;
+}
+
+static inline void counters_max(counter *const c, const uint64_t v) {
+  uint64_t *const value = counters_value(c);
+  if (v > *value)
+    *value = v;
+}
+
+#define AOC_COUNTER(id, label) static counter counter_##id = {.name = label, .kind = COUNTER_SUM};
+#define AOC_COUNTER_MAX(id, label) static counter counter_##id = {.name = label, .kind = COUNTER_MAX};
+#define AOC_COUNT(id) counters_add(&counter_##id, 1)
+#define AOC_COUNT_ADD(id, n) counters_add(&counter_##id, (n))
+#define AOC_COUNT_MAX(id, v) counters_max(&counter_##id, (v))
+
+#else
+
+#define COUNTERS_ENABLED 0
+
+#define AOC_COUNTER(id, label)
+#define AOC_COUNTER_MAX(id, label)
+#define AOC_COUNT(id) ((void)0)
+#define AOC_COUNT_ADD(id, n) ((void)0)
+#define AOC_COUNT_MAX(id, v) ((void)0)
+
+#endif
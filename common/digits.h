@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+// integer replacements for pow(10, n) and log10(n). no rounding issues for big numbers and no libm calls in hot loops
+
+static const uint64_t digits_pow10[20] = {
+    1,
+    10,
+    100,
+    1000,
+    10000,
+    100000,
+    1000000,
+    10000000,
+    100000000,
+    1000000000,
+    10000000000,
+    100000000000,
+    1000000000000,
+    10000000000000,
+    100000000000000,
+    1000000000000000,
+    10000000000000000,
+    100000000000000000,
+    1000000000000000000,
+    10000000000000000000u,
+};
+
+static inline uint64_t pow10_u64(const uint32_t n) {
+  return digits_pow10[n];
+}
+
+// amount of decimal digits. 0 has 1 digit.
+// bit length * log10(2) (1233 / 4096) estimates the digit count. it's either correct or one too big, the table lookup
+// fixes that
+static inline uint32_t digit_count_u64(const uint64_t n) {
+  const uint64_t m = n | 1; // same digit count, but clz is undefined for 0
+  const uint32_t bits = 64 - __builtin_clzll(m);
+  const uint32_t estimate = (bits * 1233) >> 12;
+  return estimate - (m < digits_pow10[estimate]) + 1;
+}
+
+// splits the number into `groups` groups of `group_digits` digits each. output[0] is the most significant group
+static inline void digits_split_u64(uint64_t n, const uint32_t group_digits, const uint32_t groups,
+                                    uint64_t *const output) {
+  const uint64_t divisor = digits_pow10[group_digits];
+  for (int64_t i = groups - 1; i >= 0; --i) {
+    output[i] = n % divisor;
+    n /= divisor;
+  }
+}
+
+// concatenates `n` (with `digit_count` digits) `repetitions` times. 12 with 2 digits and 3 repetitions -> 121212
+static inline uint64_t digits_repeat_u64(const uint64_t n, const uint32_t digit_count, const uint32_t repetitions) {
+  const uint64_t shift = digits_pow10[digit_count];
+  uint64_t result = 0;
+  for (uint32_t i = 0; i < repetitions; ++i)
+    result = result * shift + n;
+  return result;
+}
+
+// 1234 -> 4321. trailing zeros get lost (1200 -> 21)
+static inline uint64_t digits_reverse_u64(uint64_t n) {
+  uint64_t result = 0;
+  while (n > 0) {
+    result = result * 10 + n % 10;
+    n /= 10;
+  }
+  return result;
+}
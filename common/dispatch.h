@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// runtime selection of simd variants. the release build targets plain x86-64, so a hot loop only gets sse2 unless it
+// is compiled for more. DISPATCH_KERNEL compiles one kernel written in plain c several times, each variant with gcc
+// allowed to use another instruction set when vectorizing it, and calls the best one the cpu supports
+//
+//   AOC_SIMD=<level> or --simd <level> on a day forces a level for benchmarking: scalar, sse4.2, avx2 or avx512.
+//   levels the cpu doesn't support fall back to the best one it does
+//
+// "scalar" is the baseline x86-64 build, which still has sse2. write kernels without early exits and with simple
+// indexing, otherwise gcc won't vectorize them in any variant
+
+typedef enum dispatch_level {
+  DISPATCH_SCALAR,
+  DISPATCH_SSE42,
+  DISPATCH_AVX2,
+  DISPATCH_AVX512,
+  DISPATCH_LEVEL_COUNT,
+} dispatch_level;
+
+static const char *const dispatch_level_names[DISPATCH_LEVEL_COUNT] = {
+    [DISPATCH_SCALAR] = "scalar",
+    [DISPATCH_SSE42] = "sse4.2",
+    [DISPATCH_AVX2] = "avx2",
+    [DISPATCH_AVX512] = "avx512",
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DISPATCH_X86 1
+#define DISPATCH_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define DISPATCH_TARGET_AVX2 __attribute__((target("avx2,fma,bmi2")))
+#define DISPATCH_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,fma,bmi2")))
+#else
+#define DISPATCH_X86 0
+#define DISPATCH_TARGET_SSE42
+#define DISPATCH_TARGET_AVX2
+#define DISPATCH_TARGET_AVX512
+#endif
+
+// the forced level. -1 if none. weak so all translation units of the aoc runner share it
+__attribute__((weak)) _Atomic int dispatch_forced = -1;
+
+static inline dispatch_level dispatch_detect(void) {
+#if DISPATCH_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2"))
+    return DISPATCH_AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2"))
+    return DISPATCH_AVX2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return DISPATCH_SSE42;
+#endif
+  return DISPATCH_SCALAR;
+}
+
+static inline bool dispatch_parse_level(const char *const name, dispatch_level *const out) {
+  for (uint32_t i = 0; i < DISPATCH_LEVEL_COUNT; ++i) {
+    if (strcmp(name, dispatch_level_names[i]) == 0) {
+      *out = (dispatch_level)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// has to happen before the first kernel call, the kernels remember their variant
+static inline bool dispatch_force(const char *const name) {
+  dispatch_level level;
+  if (!dispatch_parse_level(name, &level))
+    return false;
+  atomic_store(&dispatch_forced, level);
+  return true;
+}
+
+static inline dispatch_level dispatch_selected(void) {
+  static _Atomic int selected = -1;
+  int level = atomic_load_explicit(&selected, memory_order_relaxed);
+  if (level >= 0)
+    return (dispatch_level)level;
+
+  const dispatch_level supported = dispatch_detect();
+  level = atomic_load(&dispatch_forced);
+  const char *const env = getenv("AOC_SIMD");
+  dispatch_level from_env;
+  if (level < 0 && env && *env != '\0') {
+    if (dispatch_parse_level(env, &from_env))
+      level = from_env;
+    else
+      fprintf(stderr, "unknown AOC_SIMD '%s'. expected scalar, sse4.2, avx2 or avx512\n", env);
+  }
+  if (level < 0) {
+    level = supported;
+  } else if (level > (int)supported) {
+    fprintf(stderr, "the cpu doesn't support %s. using %s\n", dispatch_level_names[level],
+            dispatch_level_names[supported]);
+    level = supported;
+  }
+  atomic_store_explicit(&selected, level, memory_order_relaxed);
+  return (dispatch_level)level;
+}
+
+// defines `ret name params` which forwards to the variant of `ret name##_kernel params` for the selected level. the
+// kernel has to be a static inline function defined before, so it gets inlined and vectorized into every variant:
+//
+//   static inline uint32_t sum_kernel(const uint8_t *values, uint32_t count) { ... }
+//   DISPATCH_KERNEL(uint32_t, sum, (const uint8_t *values, uint32_t count), (values, count))
+//
+// DISPATCH_KERNEL_VOID is the same for kernels without a result
+#define DISPATCH_KERNEL(ret, name, params, args) DISPATCH_KERNEL_(ret, name, params, args, return)
+#define DISPATCH_KERNEL_VOID(name, params, args) DISPATCH_KERNEL_(void, name, params, args, )
+
+#define DISPATCH_KERNEL_(ret, name, params, args, return_)                                                             \
+  typedef ret(*name##_variant) params;                                                                                 \
+  static ret name##_scalar params {                                                                                    \
+    return_ name##_kernel args;                                                                                        \
+  }                                                                                                                    \
+  DISPATCH_TARGET_SSE42 static ret name##_sse42 params {                                                               \
+    return_ name##_kernel args;                                                                                        \
+  }                                                                                                                    \
+  DISPATCH_TARGET_AVX2 static ret name##_avx2 params {                                                                 \
+    return_ name##_kernel args;                                                                                        \
+  }                                                                                                                    \
+  DISPATCH_TARGET_AVX512 static ret name##_avx512 params {                                                             \
+    return_ name##_kernel args;                                                                                        \
+  }                                                                                                                    \
+  static ret name params {                                                                                             \
+    static const name##_variant variants[DISPATCH_LEVEL_COUNT] = {name##_scalar, name##_sse42, name##_avx2,            \
+                                                                  name##_avx512};                                      \
+    static name##_variant _Atomic variant = NULL;                                                                      \
+    name##_variant v = atomic_load_explicit(&variant, memory_order_relaxed);                                           \
+    if (!v) {                                                                                                          \
+      v = variants[dispatch_selected()];                                                                               \
+      atomic_store_explicit(&variant, v, memory_order_relaxed);                                                        \
+    }                                                                                                                  \
+    return_ v args;                                                                                                    \
+  }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "digits.h"
+
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// drop in replacement for strtoul(p, &end, 10) for unsigned decimal numbers without sign, whitespace or overflow
+// handling. parses up to 8 digits per step with SWAR and 16 per step with SSE4.1 (if compiled with it).
+//
+// the wide loads can read a few bytes past the end of the number. they are only done when they stay in the same page, so
+// they can't fault. asan doesn't know that, that's why the functions are excluded from it
+
+#define FASTINT_PAGE_SIZE 4096
+#define FASTINT_NO_ASAN __attribute__((no_sanitize_address))
+
+#define FASTINT_FITS_IN_PAGE(p, n) (((uintptr_t)(p) & (FASTINT_PAGE_SIZE - 1)) <= FASTINT_PAGE_SIZE - (n))
+
+typedef uint64_t fastint_unaligned_u64 __attribute__((aligned(1), may_alias));
+
+// parses the leading digits of the 8 bytes at `p`. returns the amount of digits in `count`
+FASTINT_NO_ASAN static inline uint64_t fastint_parse_8(const char *p, uint32_t *const count) {
+  const uint64_t chunk = *(const fastint_unaligned_u64 *)p;
+  // digits become 0-9. anything else either has a high nibble or overflows into it when adding 6
+  const uint64_t values = chunk ^ 0x3030303030303030ull;
+  const uint64_t non_digits = (values | (values + 0x0606060606060606ull)) & 0xf0f0f0f0f0f0f0f0ull;
+  const uint32_t n = non_digits == 0 ? 8 : __builtin_ctzll(non_digits) / 8;
+  *count = n;
+  if (n == 0)
+    return 0;
+
+  // move the digits to the top so the missing ones become leading zeros
+  uint64_t v = values << (8 * (8 - n));
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000ff000000ffull) * (100 + (1000000ull << 32))) +
+       (((v >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >>
+      32;
+  return v;
+}
+
+#if defined(__SSE4_1__)
+
+// index table for moving the leading digits to the end of the vector. loading at offset n gives 16 - n zeroing indices
+// followed by 0..n-1
+static const int8_t fastint_shuffle_table[32] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+};
+
+FASTINT_NO_ASAN static inline uint64_t fastint_parse_16(const char *p, uint32_t *const count) {
+  const __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+  const __m128i is_digit =
+      _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+  const uint32_t n = __builtin_ctz(~(uint32_t)_mm_movemask_epi8(is_digit));
+  *count = n;
+  if (n == 0)
+    return 0;
+
+  const __m128i shuffle = _mm_loadu_si128((const __m128i *)(fastint_shuffle_table + n));
+  const __m128i digits = _mm_shuffle_epi8(_mm_sub_epi8(chunk, _mm_set1_epi8('0')), shuffle);
+  const __m128i pairs = _mm_maddubs_epi16(digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+  const __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+  const __m128i packed = _mm_packus_epi32(quads, quads);
+  const __m128i octs = _mm_madd_epi16(packed, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+  return (uint64_t)(uint32_t)_mm_cvtsi128_si32(octs) * 100000000 + (uint32_t)_mm_extract_epi32(octs, 1);
+}
+
+#endif
+
+FASTINT_NO_ASAN static inline uint64_t fastint_parse_u64(const char *p, char **end) {
+  uint64_t result = 0;
+  uint32_t n = 0;
+  for (;;) {
+#if defined(__SSE4_1__)
+    if (FASTINT_FITS_IN_PAGE(p, 16)) {
+      const uint64_t v = fastint_parse_16(p, &n);
+      result = result * pow10_u64(n) + v;
+      p += n;
+      if (n < 16)
+        break;
+      continue;
+    }
+#endif
+    if (FASTINT_FITS_IN_PAGE(p, 8)) {
+      const uint64_t v = fastint_parse_8(p, &n);
+      result = result * pow10_u64(n) + v;
+      p += n;
+      if (n < 8)
+        break;
+    } else {
+      // close to the end of a page. go byte by byte until the next page starts
+      if ((uint8_t)(*p - '0') > 9)
+        break;
+      result = result * 10 + (*p - '0');
+      ++p;
+    }
+  }
+  if (end)
+    *end = (char *)p;
+  return result;
+}
+
+static inline uint32_t fastint_parse_u32(const char *p, char **end) {
+  return (uint32_t)fastint_parse_u64(p, end);
+}
@@ -3,22 +3,195 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-static bool fileutils_read_all(const char *file_name, char **out, size_t *length) {
-  FILE *f = fopen(file_name, "r");
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "-" reads from stdin
+static inline bool fileutils_read_all(const char *file_name, char **out, size_t *length) {
+  FILE *f = strcmp(file_name, "-") == 0 ? stdin : fopen(file_name, "r");
   if (!f) {
     fprintf(stderr, "couldn't open file '%s'\n", file_name);
     return false;
   }
-  fseek(f, 0, SEEK_END);
-  const size_t size = ftell(f);
-  rewind(f);
-  char *buffer = malloc(size + 1);
-  fread(buffer, size, 1, f);
-  fclose(f);
+  // no fseek/ftell because that doesn't work for pipes. just grow the buffer until everything is read
+  size_t capacity = 4096;
+  size_t size = 0;
+  char *buffer = malloc(capacity);
+  for (;;) {
+    size += fread(buffer + size, 1, capacity - size - 1, f);
+    if (size + 1 < capacity)
+      break;
+    capacity *= 2;
+    buffer = realloc(buffer, capacity);
+  }
+  if (f != stdin)
+    fclose(f);
   buffer[size] = '\0';
   *out = buffer;
   *length = size + 1;
   return true;
 }
 
+typedef struct fileutils_mapping {
+  char *data;
+  size_t length;      // same as fileutils_read_all. includes the zero terminator
+  size_t mapped_size; // 0 if the data was read into a heap buffer instead
+} fileutils_mapping;
+
+// maps the file read only so the parsers can run straight over the page cache without copying it first.
+// a zeroed anonymous region is reserved one byte bigger than the file and the file is mapped over the front of it. that
+// way there is always a '\0' after the last byte, even when the file size is a multiple of the page size.
+// falls back to fileutils_read_all for anything that is not a regular file (or can't be mapped)
+static inline bool fileutils_map(const char *file_name, fileutils_mapping *const m) {
+  if (strcmp(file_name, "-") == 0) {
+    m->mapped_size = 0;
+    return fileutils_read_all(file_name, &m->data, &m->length);
+  }
+
+  const int fd = open(file_name, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "couldn't open file '%s'\n", file_name);
+    return false;
+  }
+
+  struct stat st = {0};
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    goto fallback;
+
+  const size_t size = st.st_size;
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t mapped_size = (size + 1 + page_size - 1) & ~(page_size - 1);
+
+  char *region = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED)
+    goto fallback;
+
+  if (mmap(region, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(region, mapped_size);
+    goto fallback;
+  }
+  close(fd);
+  madvise(region, mapped_size, MADV_SEQUENTIAL);
+
+  m->data = region;
+  m->length = size + 1;
+  m->mapped_size = mapped_size;
+  return true;
+
+fallback:
+  close(fd);
+  m->mapped_size = 0;
+  return fileutils_read_all(file_name, &m->data, &m->length);
+}
+
+static inline void fileutils_unmap(fileutils_mapping *const m) {
+  if (m->mapped_size > 0)
+    munmap(m->data, m->mapped_size);
+  else
+    free(m->data);
+  m->data = NULL;
+  m->length = 0;
+  m->mapped_size = 0;
+}
+
+#ifndef FILEUTILS_CHUNK_SIZE
+#define FILEUTILS_CHUNK_SIZE (64 * 1024)
+#endif
+
+// streams a file (or stdin with "-") in fixed size chunks. every chunk is zero terminated and ends right after a
+// delimiter, so the parsers never see half a record. the partial record at the end of a read is carried over to the
+// front of the buffer for the next chunk. the buffer only grows if a single record doesn't fit into it
+typedef struct fileutils_reader {
+  char *buffer;
+  size_t capacity;
+  size_t filled;    // bytes read into the buffer
+  size_t chunk_end; // end of the chunk handed out last. everything behind it is carried over
+  int fd;
+  char delimiter;
+  char saved; // the byte that was overwritten by the zero terminator
+  bool eof;
+} fileutils_reader;
+
+static inline bool fileutils_reader_open(const char *file_name, const char delimiter, fileutils_reader *const r) {
+  r->fd = strcmp(file_name, "-") == 0 ? STDIN_FILENO : open(file_name, O_RDONLY);
+  if (r->fd < 0) {
+    fprintf(stderr, "couldn't open file '%s'\n", file_name);
+    return false;
+  }
+  posix_fadvise(r->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  r->capacity = FILEUTILS_CHUNK_SIZE;
+  r->buffer = malloc(r->capacity + 1); // +1 for the zero terminator of a chunk that fills the whole buffer
+  r->filled = 0;
+  r->chunk_end = 0;
+  r->delimiter = delimiter;
+  r->saved = '\0';
+  r->eof = false;
+  return true;
+}
+
+static inline bool fileutils_reader_next(fileutils_reader *const r, char **chunk, size_t *const length) {
+  // move the carry to the front
+  r->buffer[r->chunk_end] = r->saved;
+  const size_t carry = r->filled - r->chunk_end;
+  memmove(r->buffer, r->buffer + r->chunk_end, carry);
+  r->filled = carry;
+  r->chunk_end = 0;
+
+  size_t search_from = 0;
+  for (;;) {
+    while (!r->eof && r->filled < r->capacity) {
+      const ssize_t n = read(r->fd, r->buffer + r->filled, r->capacity - r->filled);
+      if (n < 0) {
+        perror("read");
+        r->eof = true;
+      } else if (n == 0) {
+        r->eof = true;
+      } else {
+        r->filled += n;
+      }
+    }
+
+    if (r->eof) {
+      // whatever is left is the last chunk, no matter if it ends with a delimiter or not
+      r->chunk_end = r->filled;
+      break;
+    }
+
+    const char *last = NULL;
+    for (size_t i = r->filled; i > search_from; --i) {
+      if (r->buffer[i - 1] == r->delimiter) {
+        last = &r->buffer[i - 1];
+        break;
+      }
+    }
+    if (last) {
+      r->chunk_end = last - r->buffer + 1;
+      break;
+    }
+
+    // a single record is bigger than the buffer
+    search_from = r->filled;
+    r->capacity *= 2;
+    r->buffer = realloc(r->buffer, r->capacity + 1);
+  }
+
+  if (r->chunk_end == 0)
+    return false;
+
+  r->saved = r->buffer[r->chunk_end];
+  r->buffer[r->chunk_end] = '\0';
+  *chunk = r->buffer;
+  *length = r->chunk_end + 1;
+  return true;
+}
+
+static inline void fileutils_reader_close(fileutils_reader *const r) {
+  if (r->fd != STDIN_FILENO)
+    close(r->fd);
+  free(r->buffer);
+  r->buffer = NULL;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// xxh64 (https://github.com/Cyan4973/xxHash). same results as the reference implementation. the four independent
+// accumulators of the 32 byte loop keep the multipliers busy, which is where the speed comes from. no table and nothing
+// to set up, so hashing a whole input costs about as much as reading it once
+
+#define HASH_PRIME64_1 0x9E3779B185EBCA87ull
+#define HASH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME64_3 0x165667B19E3779F9ull
+#define HASH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define HASH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t hash_rotl64(const uint64_t x, const int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+// memcpy instead of a cast so unaligned input is fine. compiles to a plain load
+static inline uint64_t hash_read64(const unsigned char *const p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t hash_read32(const unsigned char *const p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, const uint64_t input) {
+  acc += input * HASH_PRIME64_2;
+  acc = hash_rotl64(acc, 31);
+  return acc * HASH_PRIME64_1;
+}
+
+static inline uint64_t hash_merge_round(uint64_t acc, const uint64_t value) {
+  acc ^= hash_round(0, value);
+  return acc * HASH_PRIME64_1 + HASH_PRIME64_4;
+}
+
+static inline uint64_t hash_xxh64(const void *const data, const size_t length, const uint64_t seed) {
+  const unsigned char *p = data;
+  const unsigned char *const end = p + length;
+  uint64_t h;
+
+  if (length >= 32) {
+    uint64_t v1 = seed + HASH_PRIME64_1 + HASH_PRIME64_2;
+    uint64_t v2 = seed + HASH_PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - HASH_PRIME64_1;
+    const unsigned char *const limit = end - 32;
+    do {
+      v1 = hash_round(v1, hash_read64(p));
+      v2 = hash_round(v2, hash_read64(p + 8));
+      v3 = hash_round(v3, hash_read64(p + 16));
+      v4 = hash_round(v4, hash_read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+
+    h = hash_rotl64(v1, 1) + hash_rotl64(v2, 7) + hash_rotl64(v3, 12) + hash_rotl64(v4, 18);
+    h = hash_merge_round(h, v1);
+    h = hash_merge_round(h, v2);
+    h = hash_merge_round(h, v3);
+    h = hash_merge_round(h, v4);
+  } else {
+    h = seed + HASH_PRIME64_5;
+  }
+  h += length;
+
+  for (; p + 8 <= end; p += 8) {
+    h ^= hash_round(0, hash_read64(p));
+    h = hash_rotl64(h, 27) * HASH_PRIME64_1 + HASH_PRIME64_4;
+  }
+  if (p + 4 <= end) {
+    h ^= (uint64_t)hash_read32(p) * HASH_PRIME64_1;
+    h = hash_rotl64(h, 23) * HASH_PRIME64_2 + HASH_PRIME64_3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= *p * HASH_PRIME64_5;
+    h = hash_rotl64(h, 11) * HASH_PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= HASH_PRIME64_2;
+  h ^= h >> 29;
+  h *= HASH_PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
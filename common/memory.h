@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "../ext/toolbelt/src/assert.h"
+
+// big buffers with a choice of page size. the scratch chunks come from here. random accesses over megabytes of 4KB
+// pages miss the dtlb all the time, 2MB pages cover the same memory with 512 times fewer entries
+//
+//   AOC_HUGE_PAGES=off       4KB pages, even if the kernel would hand out transparent huge pages on its own
+//   AOC_HUGE_PAGES=thp       madvise(MADV_HUGEPAGE) on 2MB aligned memory
+//   AOC_HUGE_PAGES=hugetlb   MAP_HUGETLB from the reserved pool (/proc/sys/vm/nr_hugepages). falls back to thp once
+//                            the pool is empty
+//
+// unset leaves it to malloc and the kernel's thp setting. allocations below MEMORY_LARGE_SIZE always go to malloc,
+// they would waste most of a huge page. `--counters` on a day shows the dtlb misses to compare the modes
+
+#define MEMORY_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define MEMORY_LARGE_SIZE MEMORY_HUGE_PAGE_SIZE
+#define MEMORY_ALIGNMENT 64
+
+typedef enum memory_huge_pages {
+  MEMORY_HUGE_PAGES_DEFAULT,
+  MEMORY_HUGE_PAGES_OFF,
+  MEMORY_HUGE_PAGES_THP,
+  MEMORY_HUGE_PAGES_HUGETLB,
+} memory_huge_pages;
+
+static const char *const memory_huge_pages_names[] = {
+    [MEMORY_HUGE_PAGES_DEFAULT] = "default",
+    [MEMORY_HUGE_PAGES_OFF] = "off",
+    [MEMORY_HUGE_PAGES_THP] = "thp",
+    [MEMORY_HUGE_PAGES_HUGETLB] = "hugetlb",
+};
+
+// in front of every allocation. the data starts MEMORY_ALIGNMENT bytes after it
+typedef struct memory_header {
+  void *base;    // of the mapping. NULL if it came from malloc
+  size_t length; // of the mapping
+} memory_header;
+
+_Static_assert(sizeof(memory_header) <= MEMORY_ALIGNMENT, "the header has to fit in front of the data");
+
+static inline memory_huge_pages memory_huge_pages_mode(void) {
+  // every thread reads the same environment, so a race only parses it twice
+  static _Atomic int mode = -1;
+  if (mode < 0) {
+    const char *const value = getenv("AOC_HUGE_PAGES");
+    memory_huge_pages m = MEMORY_HUGE_PAGES_DEFAULT;
+    if (value && strcmp(value, "off") == 0)
+      m = MEMORY_HUGE_PAGES_OFF;
+    else if (value && strcmp(value, "thp") == 0)
+      m = MEMORY_HUGE_PAGES_THP;
+    else if (value && strcmp(value, "hugetlb") == 0)
+      m = MEMORY_HUGE_PAGES_HUGETLB;
+    else if (value && *value != '\0')
+      fprintf(stderr, "unknown AOC_HUGE_PAGES '%s'. expected off, thp or hugetlb\n", value);
+    mode = m;
+  }
+  return (memory_huge_pages)mode;
+}
+
+static inline void *memory_map(const size_t size, const memory_huge_pages mode) {
+  const size_t length = (size + MEMORY_ALIGNMENT + MEMORY_HUGE_PAGE_SIZE - 1) & ~(size_t)(MEMORY_HUGE_PAGE_SIZE - 1);
+  if (mode == MEMORY_HUGE_PAGES_HUGETLB) {
+    char *const base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED) {
+      *(memory_header *)base = (memory_header){.base = base, .length = length};
+      return base + MEMORY_ALIGNMENT;
+    }
+    static bool warned = false;
+    if (!warned)
+      fprintf(stderr, "no reserved huge pages left (/proc/sys/vm/nr_hugepages). using thp instead\n");
+    warned = true;
+  }
+
+  // one huge page extra so the start can be moved to a 2MB boundary, otherwise the first and last partial huge pages
+  // stay 4KB pages
+  const size_t mapped = length + MEMORY_HUGE_PAGE_SIZE;
+  char *const base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+  char *const aligned =
+      (char *)(((uintptr_t)base + MEMORY_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(MEMORY_HUGE_PAGE_SIZE - 1));
+  // a kernel without thp fails the madvise. the memory still works, just with 4KB pages
+  madvise(aligned, length, mode == MEMORY_HUGE_PAGES_OFF ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+  *(memory_header *)aligned = (memory_header){.base = base, .length = mapped};
+  return aligned + MEMORY_ALIGNMENT;
+}
+
+// MEMORY_ALIGNMENT aligned. never returns NULL
+static inline void *memory_alloc(const size_t size) {
+  const memory_huge_pages mode = memory_huge_pages_mode();
+  char *data = NULL;
+  if (mode != MEMORY_HUGE_PAGES_DEFAULT && size >= MEMORY_LARGE_SIZE)
+    data = memory_map(size, mode);
+  if (!data) {
+    const size_t length = (size + 2 * MEMORY_ALIGNMENT - 1) & ~(size_t)(MEMORY_ALIGNMENT - 1);
+    char *const base = aligned_alloc(MEMORY_ALIGNMENT, length);
+    tlbt_assert_fmt(base != NULL, "couldn't allocate %zu bytes", size);
+    *(memory_header *)base = (memory_header){0};
+    data = base + MEMORY_ALIGNMENT;
+  }
+  return data;
+}
+
+static inline void memory_free(void *const data) {
+  if (!data)
+    return;
+  memory_header *const h = (memory_header *)((char *)data - MEMORY_ALIGNMENT);
+  if (h->base)
+    munmap(h->base, h->length);
+  else
+    free(h);
+}
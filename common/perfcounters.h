@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// hardware performance counters through perf_event_open. all counters are in one group so they get scheduled together
+// and can be read with a single read call. counters the cpu (or vm) doesn't support are skipped. if not even the cycle
+// counter can be opened (no pmu, perf_event_paranoid too strict, ...) everything is unavailable and reads return zeros
+
+typedef enum perf_counter {
+  PERF_COUNTER_CYCLES,
+  PERF_COUNTER_INSTRUCTIONS,
+  PERF_COUNTER_L1D_MISSES,
+  PERF_COUNTER_LLC_MISSES,
+  PERF_COUNTER_BRANCH_MISSES,
+  PERF_COUNTER_DTLB_MISSES,
+  PERF_COUNTER_COUNT,
+} perf_counter;
+
+static const char *const perf_counter_names[PERF_COUNTER_COUNT] = {
+    [PERF_COUNTER_CYCLES] = "cycles",
+    [PERF_COUNTER_INSTRUCTIONS] = "instructions",
+    [PERF_COUNTER_L1D_MISSES] = "l1d_misses",
+    [PERF_COUNTER_LLC_MISSES] = "llc_misses",
+    [PERF_COUNTER_BRANCH_MISSES] = "branch_misses",
+    [PERF_COUNTER_DTLB_MISSES] = "dtlb_misses",
+};
+
+typedef struct perf_counters {
+  int fds[PERF_COUNTER_COUNT];
+  uint8_t group_index[PERF_COUNTER_COUNT]; // position in the group read
+  uint8_t active_count;
+  bool available[PERF_COUNTER_COUNT];
+} perf_counters;
+
+typedef struct perf_values {
+  uint64_t values[PERF_COUNTER_COUNT];
+} perf_values;
+
+static inline void perf_counter_attr(const perf_counter counter, struct perf_event_attr *const attr) {
+  memset(attr, 0, sizeof(*attr));
+  attr->size = sizeof(*attr);
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_GROUP;
+  switch (counter) {
+  case PERF_COUNTER_CYCLES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case PERF_COUNTER_INSTRUCTIONS:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case PERF_COUNTER_L1D_MISSES:
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  case PERF_COUNTER_LLC_MISSES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  case PERF_COUNTER_BRANCH_MISSES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  case PERF_COUNTER_DTLB_MISSES:
+    // loads only. most cpus don't count store misses separately
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  default:
+    break;
+  }
+}
+
+// returns false if no counter at all could be opened
+static inline bool perf_counters_open(perf_counters *const pc) {
+  *pc = (perf_counters){0};
+  int leader = -1;
+  for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    struct perf_event_attr attr;
+    perf_counter_attr(i, &attr);
+    attr.disabled = leader == -1; // only the leader gets enabled, the others follow it
+    const int fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+    pc->fds[i] = fd;
+    if (fd < 0) {
+      if (leader == -1)
+        return false; // without cycles the rest isn't worth much
+      continue;
+    }
+    if (leader == -1)
+      leader = fd;
+    pc->available[i] = true;
+    pc->group_index[i] = pc->active_count++;
+  }
+
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+static inline void perf_counters_read(const perf_counters *const pc, perf_values *const out) {
+  *out = (perf_values){0};
+  if (pc->active_count == 0)
+    return;
+
+  uint64_t buffer[1 + PERF_COUNTER_COUNT] = {0}; // nr followed by the values
+  if (read(pc->fds[PERF_COUNTER_CYCLES], buffer, sizeof(buffer)) <= 0)
+    return;
+  for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    if (pc->available[i])
+      out->values[i] = buffer[1 + pc->group_index[i]];
+  }
+}
+
+static inline void perf_counters_close(perf_counters *const pc) {
+  for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    if (pc->available[i])
+      close(pc->fds[i]);
+  }
+  pc->active_count = 0;
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../ext/toolbelt/src/assert.h"
+#include "trace.h"
+
+// fixed size work-stealing thread pool. every worker owns a chase-lev deque (le et al., "correct and efficient
+// work-stealing for weak memory models"): the owner pushes and pops at the bottom, idle workers steal from the top. the
+// thread which created the pool gets a deque as well and works on tasks while it waits, so nested fork/join doesn't
+// block a thread.
+//
+// tasks can only be spawned from the creating thread and from inside tasks. tasks aren't copied, they have to stay
+// alive until the group they belong to is waited for
+
+// tasks per deque. spawning more without running them is a bug
+#ifndef POOL_DEQUE_CAPACITY
+#define POOL_DEQUE_CAPACITY 4096
+#endif
+
+#define POOL_MAX_THREADS 64
+
+typedef struct pool pool;
+typedef struct pool_group pool_group;
+
+typedef struct pool_task {
+  void (*func)(void *arg);
+  void *arg;
+  pool_group *group;
+} pool_task;
+
+struct pool_group {
+  atomic_uint pending;
+};
+
+typedef struct pool_deque {
+  _Alignas(64) atomic_llong top;
+  _Alignas(64) atomic_llong bottom;
+  _Alignas(64) pool_task *_Atomic tasks[POOL_DEQUE_CAPACITY];
+} pool_deque;
+
+struct pool {
+  pool_deque *deques; // thread_count + 1. the last one belongs to the creating thread
+  pthread_t threads[POOL_MAX_THREADS];
+  uint32_t thread_count;
+  atomic_bool stop;
+};
+
+typedef struct pool_worker {
+  pool *p;
+  uint32_t index;
+  uint32_t random; // xorshift state for picking victims
+} pool_worker;
+
+// the pool the current thread works for. weak so all translation units of the aoc runner see the same one
+__attribute__((weak)) _Thread_local pool_worker *pool_self = NULL;
+
+static inline void pool_deque_push(pool_deque *const d, pool_task *const t) {
+  const long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  // checked in release builds as well, a full ring would overwrite tasks which haven't run yet
+  if (b - atomic_load_explicit(&d->top, memory_order_acquire) >= POOL_DEQUE_CAPACITY) {
+    fprintf(stderr, "pool deque full. max: %u\n", POOL_DEQUE_CAPACITY);
+    abort();
+  }
+  atomic_store_explicit(&d->tasks[b & (POOL_DEQUE_CAPACITY - 1)], t, memory_order_relaxed);
+  // release store instead of the paper's release fence + relaxed store. same effect and tsan understands it
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+}
+
+// owner only
+static inline pool_task *pool_deque_pop(pool_deque *const d) {
+  const long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long long top = atomic_load_explicit(&d->top, memory_order_relaxed);
+  if (top > b) {
+    // empty
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return NULL;
+  }
+  pool_task *t = atomic_load_explicit(&d->tasks[b & (POOL_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+  if (top == b) {
+    // last one. race against the thieves for it
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+      t = NULL;
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  }
+  return t;
+}
+
+// any thread
+static inline pool_task *pool_deque_steal(pool_deque *const d) {
+  long long top = atomic_load_explicit(&d->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  const long long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+  if (top >= b)
+    return NULL;
+  pool_task *t = atomic_load_explicit(&d->tasks[top & (POOL_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+    return NULL; // somebody else was faster
+  return t;
+}
+
+static inline void pool_run(pool_task *const t) {
+  t->func(t->arg);
+  atomic_fetch_sub_explicit(&t->group->pending, 1, memory_order_release);
+}
+
+// own deque first, then the others starting at a random one
+static inline pool_task *pool_find_task(pool_worker *const w) {
+  pool *const p = w->p;
+  pool_task *t = pool_deque_pop(&p->deques[w->index]);
+  if (t)
+    return t;
+
+  w->random ^= w->random << 13;
+  w->random ^= w->random >> 17;
+  w->random ^= w->random << 5;
+  const uint32_t deque_count = p->thread_count + 1;
+  const uint32_t start = w->random % deque_count;
+  for (uint32_t i = 0; i < deque_count; ++i) {
+    const uint32_t victim = (start + i) % deque_count;
+    if (victim != w->index && (t = pool_deque_steal(&p->deques[victim])))
+      return t;
+  }
+  return NULL;
+}
+
+// spin a little, then yield, then sleep so idle workers don't eat a whole core
+static inline void pool_idle(uint32_t *const idle_rounds) {
+  const uint32_t rounds = (*idle_rounds)++;
+  if (rounds < 64)
+    return;
+  if (rounds < 128) {
+    sched_yield();
+    return;
+  }
+  nanosleep(&(struct timespec){.tv_nsec = 50000}, NULL);
+}
+
+static inline void *pool_worker_main(void *arg) {
+  pool_worker w = *(pool_worker *)arg;
+  free(arg);
+  pool_self = &w;
+  uint32_t idle_rounds = 0;
+  while (!atomic_load_explicit(&w.p->stop, memory_order_acquire)) {
+    pool_task *const t = pool_find_task(&w);
+    if (t) {
+      pool_run(t);
+      idle_rounds = 0;
+    } else {
+      pool_idle(&idle_rounds);
+    }
+  }
+  return NULL;
+}
+
+static inline uint32_t pool_default_thread_count(void) {
+  const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus < 1 ? 1 : cpus > POOL_MAX_THREADS ? POOL_MAX_THREADS : (uint32_t)cpus;
+}
+
+// all tasks have to be finished already
+static inline void pool_destroy(pool *const p) {
+  atomic_store_explicit(&p->stop, true, memory_order_release);
+  for (uint32_t i = 0; i < p->thread_count; ++i)
+    pthread_join(p->threads[i], NULL);
+  free(pool_self);
+  pool_self = NULL;
+  free(p->deques);
+  p->deques = NULL;
+}
+
+// thread_count workers besides the calling thread. 0 -> one less than there are cpus since the caller works as well
+static inline bool pool_create(pool *const p, uint32_t thread_count) {
+  if (thread_count == 0)
+    thread_count = pool_default_thread_count() - 1;
+  tlbt_assert_fmt(thread_count < POOL_MAX_THREADS, "too many threads. max: %u", POOL_MAX_THREADS - 1);
+  tlbt_assert_msg(pool_self == NULL, "the calling thread already belongs to a pool");
+
+  *p = (pool){.thread_count = thread_count};
+  p->deques = aligned_alloc(_Alignof(pool_deque), sizeof(pool_deque) * (thread_count + 1));
+  if (!p->deques)
+    return false;
+  for (uint32_t i = 0; i <= thread_count; ++i) {
+    atomic_init(&p->deques[i].top, 0);
+    atomic_init(&p->deques[i].bottom, 0);
+  }
+  atomic_init(&p->stop, false);
+
+  pool_worker *self = malloc(sizeof(pool_worker));
+  *self = (pool_worker){.p = p, .index = thread_count, .random = 2463534242u};
+  pool_self = self;
+
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    pool_worker *w = malloc(sizeof(pool_worker));
+    *w = (pool_worker){.p = p, .index = i, .random = 2463534242u + i * 7919u};
+    if (pthread_create(&p->threads[i], NULL, pool_worker_main, w) != 0) {
+      fprintf(stderr, "couldn't start pool thread %u\n", i);
+      free(w);
+      p->thread_count = i;
+      pool_destroy(p);
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline void pool_spawn(pool_group *const g, pool_task *const t, void (*func)(void *), void *arg) {
+  tlbt_assert_msg(pool_self != NULL, "tasks can only be spawned from the pool thread or from tasks");
+  *t = (pool_task){.func = func, .arg = arg, .group = g};
+  atomic_fetch_add_explicit(&g->pending, 1, memory_order_relaxed);
+  pool_deque_push(&pool_self->p->deques[pool_self->index], t);
+}
+
+// runs tasks (of any group) until everything in the group is done
+static inline void pool_wait(pool_group *const g) {
+  uint32_t idle_rounds = 0;
+  while (atomic_load_explicit(&g->pending, memory_order_acquire) != 0) {
+    pool_task *const t = pool_find_task(pool_self);
+    if (t) {
+      pool_run(t);
+      idle_rounds = 0;
+    } else {
+      pool_idle(&idle_rounds);
+    }
+  }
+}
+
+// runs a and b, in parallel if the calling thread belongs to a pool. b can be stolen while a runs here
+static inline void pool_fork_join(void (*a)(void *), void *a_arg, void (*b)(void *), void *b_arg) {
+  if (!pool_self) {
+    a(a_arg);
+    b(b_arg);
+    return;
+  }
+  pool_group g = {0};
+  pool_task t;
+  pool_spawn(&g, &t, b, b_arg);
+  a(a_arg);
+  pool_wait(&g);
+}
+
+// 0 outside a pool. lets a parallel loop give every worker its own scratch, the chunks of one worker never overlap
+static inline uint32_t pool_worker_index(void) {
+  return pool_self ? pool_self->index : 0;
+}
+
+typedef void (*pool_for_func)(void *arg, uint64_t begin, uint64_t end);
+typedef uint64_t (*pool_reduce_func)(void *arg, uint64_t begin, uint64_t end);
+typedef uint64_t (*pool_combine_func)(uint64_t left, uint64_t right);
+
+typedef struct pool_range {
+  pool_for_func for_func;
+  pool_reduce_func reduce_func;
+  pool_combine_func combine;
+  void *arg;
+  uint64_t begin;
+  uint64_t end;
+  uint64_t grain;
+  uint64_t result;
+} pool_range;
+
+// halves the range until it's at most grain long. the right half can be stolen while the left one gets split further
+// here, so idle workers take big chunks and the splitting only goes as deep as there are thieves to feed. when tracing
+// every chunk shows up on the thread which ran it
+static inline void pool_range_run(void *arg) {
+  pool_range *const r = arg;
+  if (r->end - r->begin <= r->grain) {
+    const uint64_t start = trace_active ? trace_now() : 0;
+    if (r->for_func)
+      r->for_func(r->arg, r->begin, r->end);
+    else
+      r->result = r->reduce_func(r->arg, r->begin, r->end);
+    trace_span("parallel chunk", "pool", start);
+    return;
+  }
+  const uint64_t mid = r->begin + (r->end - r->begin) / 2;
+  pool_range left = *r;
+  pool_range right = *r;
+  left.end = mid;
+  right.begin = mid;
+  pool_fork_join(pool_range_run, &left, pool_range_run, &right);
+  if (r->reduce_func)
+    r->result = r->combine(left.result, right.result);
+}
+
+// calls func on chunks of [begin, end) with at most grain indices (0 -> 1). in parallel if the calling thread belongs
+// to a pool, otherwise once with the whole range
+static inline void pool_parallel_for(const uint64_t begin, const uint64_t end, const uint64_t grain,
+                                     const pool_for_func func, void *const arg) {
+  if (begin >= end)
+    return;
+  if (!pool_self) {
+    func(arg, begin, end);
+    return;
+  }
+  pool_range r = {.for_func = func, .arg = arg, .begin = begin, .end = end, .grain = grain ? grain : 1};
+  pool_range_run(&r);
+}
+
+// like pool_parallel_for, but func returns a value per chunk and combine merges neighbouring chunks, left before
+// right. combine has to be associative, then the result doesn't depend on how the range got split. identity is
+// returned for an empty range
+static inline uint64_t pool_parallel_reduce(const uint64_t begin, const uint64_t end, const uint64_t grain,
+                                            const pool_reduce_func func, void *const arg,
+                                            const pool_combine_func combine, const uint64_t identity) {
+  if (begin >= end)
+    return identity;
+  if (!pool_self)
+    return func(arg, begin, end);
+  pool_range r = {.reduce_func = func,
+                  .combine = combine,
+                  .arg = arg,
+                  .begin = begin,
+                  .end = end,
+                  .grain = grain ? grain : 1};
+  pool_range_run(&r);
+  return r.result;
+}
+
+static inline uint64_t pool_sum(const uint64_t left, const uint64_t right) {
+  return left + right;
+}
+
+static inline uint64_t pool_max(const uint64_t left, const uint64_t right) {
+  return left > right ? left : right;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// wire format between build/aoc-server and its clients. both ends run on the same machine (unix socket), so the
+// structs go over as they are, no byte order conversion
+//
+// a connection carries any number of requests, one after another. every request is a header followed by length bytes
+// of input and gets exactly one response. the server closes the connection after an error response
+
+#define PROTOCOL_DEFAULT_SOCKET "/tmp/aoc.sock"
+
+// every worker keeps a buffer as big as the biggest input it was sent, so this bounds the memory of the server to
+// workers * 64MB. a puzzle input is around 20KB, so that's thousands of times more than needed while still leaving
+// room for big generated inputs. it stops a broken client from making the server allocate whatever it sent as length
+#define PROTOCOL_MAX_INPUT (64u * 1024 * 1024)
+
+typedef struct protocol_request {
+  uint32_t day; // 1 to 12
+  uint32_t reserved;
+  uint64_t length;
+} protocol_request;
+
+typedef enum protocol_status {
+  PROTOCOL_STATUS_OK,
+  PROTOCOL_STATUS_UNKNOWN_DAY,
+  PROTOCOL_STATUS_INPUT_TOO_BIG,
+  PROTOCOL_STATUS_INVALID_INPUT,
+} protocol_status;
+
+typedef struct protocol_response {
+  uint32_t status; // protocol_status
+  uint32_t part_count;
+  uint64_t part1;
+  uint64_t part2;
+} protocol_response;
+
+static inline const char *protocol_status_string(const uint32_t status) {
+  switch (status) {
+  case PROTOCOL_STATUS_OK:
+    return "ok";
+  case PROTOCOL_STATUS_UNKNOWN_DAY:
+    return "unknown day";
+  case PROTOCOL_STATUS_INPUT_TOO_BIG:
+    return "input too big";
+  case PROTOCOL_STATUS_INVALID_INPUT:
+    return "invalid input";
+  default:
+    return "unknown status";
+  }
+}
+
+// "day07" or "7" -> 7. 0 if it's neither
+static inline uint32_t protocol_parse_day(const char *name) {
+  if (strncmp(name, "day", 3) == 0)
+    name += 3;
+  char *end = NULL;
+  const unsigned long day = strtoul(name, &end, 10);
+  return end != name && *end == '\0' && day >= 1 && day <= 12 ? (uint32_t)day : 0;
+}
+
+// false on eof before the first byte as well, so a closed connection ends the request loop
+static inline bool protocol_read_all(const int fd, void *const data, const size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = read(fd, (char *)data + done, size - done);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+static inline bool protocol_write_all(const int fd, const void *const data, const size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = send(fd, (const char *)data + done, size - done, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+static inline bool protocol_address(const char *const path, struct sockaddr_un *const address) {
+  *address = (struct sockaddr_un){.sun_family = AF_UNIX};
+  if (strlen(path) >= sizeof(address->sun_path)) {
+    fprintf(stderr, "socket path '%s' is too long\n", path);
+    return false;
+  }
+  strcpy(address->sun_path, path);
+  return true;
+}
+
+// -1 on error
+static inline int protocol_connect(const char *const path) {
+  struct sockaddr_un address;
+  if (!protocol_address(path, &address))
+    return -1;
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    fprintf(stderr, "couldn't connect to '%s': %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// replaces a stale socket file from a previous run. only the user who started the server can connect (0600). -1 on
+// error
+static inline int protocol_listen(const char *const path) {
+  struct sockaddr_un address;
+  if (!protocol_address(path, &address))
+    return -1;
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  unlink(path);
+  // the socket file gets its permissions from the umask at bind time. chmod after would leave a window
+  const mode_t mask = umask(0077);
+  const bool bound = bind(fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+  umask(mask);
+  if (!bound || listen(fd, SOMAXCONN) != 0) {
+    fprintf(stderr, "couldn't listen on '%s': %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// sends one input and waits for the answer
+static inline bool protocol_solve(const int fd, const uint32_t day, const char *const input, const size_t length,
+                                  protocol_response *const response) {
+  const protocol_request request = {.day = day, .length = length};
+  return protocol_write_all(fd, &request, sizeof(request)) && protocol_write_all(fd, input, length) &&
+         protocol_read_all(fd, response, sizeof(*response));
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if !defined(SCAN_FORCE_SCALAR) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
+// byte search over zero terminated buffers. every function stops at the zero terminator as well, so the result has to
+// be checked for '\0' just like with strchr.
+//
+// the vector versions only do aligned loads. an aligned load can't cross a page boundary so reading a few bytes before
+// the start or after the terminator can't fault. asan doesn't know that and would complain about it, that's why the
+// kernels are excluded from it
+
+#define SCAN_SET_MAX 8
+
+typedef struct scan_set {
+  char chars[SCAN_SET_MAX];
+  uint8_t count;
+  bool table[256]; // for the scalar version
+} scan_set;
+
+static inline void scan_set_init(scan_set *const set, const char *chars) {
+  *set = (scan_set){0};
+  set->table[0] = true;
+  for (; *chars != '\0'; ++chars) {
+    if (set->count < SCAN_SET_MAX)
+      set->chars[set->count++] = *chars;
+    set->table[(uint8_t)*chars] = true;
+  }
+}
+
+#if !defined(SCAN_FORCE_SCALAR) && defined(__AVX2__)
+
+typedef __m256i scan_vec;
+#define SCAN_VEC_WIDTH 32
+#define scan_vec_load(p) _mm256_load_si256((const __m256i *)(p))
+#define scan_vec_splat(c) _mm256_set1_epi8(c)
+#define scan_vec_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define scan_vec_or(a, b) _mm256_or_si256(a, b)
+#define scan_vec_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#define SCAN_VEC_FULL_MASK UINT32_MAX
+
+#elif !defined(SCAN_FORCE_SCALAR) && defined(__SSE2__)
+
+typedef __m128i scan_vec;
+#define SCAN_VEC_WIDTH 16
+#define scan_vec_load(p) _mm_load_si128((const __m128i *)(p))
+#define scan_vec_splat(c) _mm_set1_epi8(c)
+#define scan_vec_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define scan_vec_or(a, b) _mm_or_si128(a, b)
+#define scan_vec_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#define SCAN_VEC_FULL_MASK 0xffffu
+
+#endif
+
+#ifdef SCAN_VEC_WIDTH
+
+#define SCAN_NO_ASAN __attribute__((no_sanitize_address))
+
+// walks the aligned blocks starting with the one containing `p`. `match` has to evaluate to the movemask of the current
+// block `v`. bytes in front of `p` are masked out of the first block
+#define SCAN_VEC_LOOP(p, match)                                                                                        \
+  do {                                                                                                                 \
+    const uintptr_t misalign = (uintptr_t)(p) & (SCAN_VEC_WIDTH - 1);                                                  \
+    const char *block = (p) - misalign;                                                                                \
+    scan_vec v = scan_vec_load(block);                                                                                 \
+    uint32_t mask = (match) & (SCAN_VEC_FULL_MASK << misalign);                                                        \
+    while (mask == 0) {                                                                                                \
+      block += SCAN_VEC_WIDTH;                                                                                         \
+      v = scan_vec_load(block);                                                                                        \
+      mask = (match);                                                                                                  \
+    }                                                                                                                  \
+    return (char *)block + __builtin_ctz(mask);                                                                        \
+  } while (0)
+
+// first occurrence of `c` or the zero terminator
+SCAN_NO_ASAN static inline char *scan_find(const char *p, const char c) {
+  const scan_vec needle = scan_vec_splat(c);
+  const scan_vec zero = scan_vec_splat(0);
+  SCAN_VEC_LOOP(p, scan_vec_mask(scan_vec_or(scan_vec_eq(v, needle), scan_vec_eq(v, zero))));
+}
+
+static inline uint32_t scan_set_match(const scan_vec v, const scan_vec *const needles, const uint8_t count) {
+  scan_vec m = scan_vec_eq(v, scan_vec_splat(0));
+  for (uint8_t i = 0; i < count; ++i)
+    m = scan_vec_or(m, scan_vec_eq(v, needles[i]));
+  return scan_vec_mask(m);
+}
+
+// first occurrence of any byte in the set or the zero terminator
+SCAN_NO_ASAN static inline char *scan_find_set(const char *p, const scan_set *const set) {
+  scan_vec needles[SCAN_SET_MAX];
+  for (uint8_t i = 0; i < set->count; ++i)
+    needles[i] = scan_vec_splat(set->chars[i]);
+  SCAN_VEC_LOOP(p, scan_set_match(v, needles, set->count));
+}
+
+// first byte which is not `c`. the zero terminator is never `c` so this stops there as well
+SCAN_NO_ASAN static inline char *scan_skip(const char *p, const char c) {
+  const scan_vec needle = scan_vec_splat(c);
+  SCAN_VEC_LOOP(p, scan_vec_mask(scan_vec_eq(v, needle)) ^ SCAN_VEC_FULL_MASK);
+}
+
+#undef SCAN_VEC_LOOP
+
+#else
+
+static inline char *scan_find(const char *p, const char c) {
+  while (*p != c && *p != '\0')
+    ++p;
+  return (char *)p;
+}
+
+static inline char *scan_find_set(const char *p, const scan_set *const set) {
+  while (!set->table[(uint8_t)*p])
+    ++p;
+  return (char *)p;
+}
+
+static inline char *scan_skip(const char *p, const char c) {
+  while (*p == c)
+    ++p;
+  return (char *)p;
+}
+
+#endif
+
+// occurrences of `c` before the zero terminator. lets a day size its arrays from the input before parsing it
+static inline uint64_t scan_count(const char *p, const char c) {
+  uint64_t count = 0;
+  for (p = scan_find(p, c); *p != '\0'; p = scan_find(p + 1, c))
+    ++count;
+  return count;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../ext/toolbelt/src/assert.h"
+#include "memory.h"
+
+// growable bump allocator for the per input data of a day. it hands out memory from chunks and only asks malloc for a
+// new chunk when the current ones are full, every new chunk twice as big as the last. nothing is freed on its own:
+// scratch_clear (or scratch_reset to a mark) makes everything reusable, so once a state saw its biggest input solving
+// doesn't malloc anymore. big chunks come with huge pages if AOC_HUGE_PAGES asks for them (see memory.h)
+//
+// every scratch reports to scratch_totals. bench.h reads it around the phases and prints how much each phase
+// allocated, how many chunks it had to add and the high water mark of scratch memory in use while it ran
+
+#define SCRATCH_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+typedef struct scratch_chunk {
+  struct scratch_chunk *next;
+  size_t size; // of data
+  size_t used;
+  _Alignas(64) char data[];
+} scratch_chunk;
+
+typedef struct scratch {
+  scratch_chunk *first;
+  scratch_chunk *current; // the chunks after it are unused
+  size_t next_chunk_size;
+  size_t in_use; // bytes handed out since the last clear, padding included
+  size_t high_water;
+  uint32_t chunk_count;
+} scratch;
+
+typedef struct scratch_mark {
+  scratch_chunk *chunk;
+  size_t used;
+  size_t in_use;
+} scratch_mark;
+
+// over all scratches of the process. atomic since the workers of a parallel loop allocate at the same time
+typedef struct scratch_accounting {
+  atomic_uint_fast64_t allocated; // bytes, ever
+  atomic_uint_fast64_t chunks;    // ever
+  atomic_uint_fast64_t in_use;
+  atomic_uint_fast64_t high_water; // of in_use. bench.h resets it per phase
+} scratch_accounting;
+
+// weak so all translation units of the aoc runner share it
+__attribute__((weak)) scratch_accounting scratch_totals;
+
+static inline void scratch_raise_high_water(const uint64_t value) {
+  uint64_t high_water = atomic_load_explicit(&scratch_totals.high_water, memory_order_relaxed);
+  while (value > high_water && !atomic_compare_exchange_weak_explicit(&scratch_totals.high_water, &high_water, value,
+                                                                      memory_order_relaxed, memory_order_relaxed))
+    ;
+}
+
+static inline void scratch_account(const uint64_t bytes) {
+  atomic_fetch_add_explicit(&scratch_totals.allocated, bytes, memory_order_relaxed);
+  const uint64_t in_use = atomic_fetch_add_explicit(&scratch_totals.in_use, bytes, memory_order_relaxed) + bytes;
+  scratch_raise_high_water(in_use);
+}
+
+static inline void scratch_unaccount(const uint64_t bytes) {
+  atomic_fetch_sub_explicit(&scratch_totals.in_use, bytes, memory_order_relaxed);
+}
+
+static inline scratch_chunk *scratch_chunk_create(scratch *const s, const size_t min_size) {
+  size_t size = s->next_chunk_size;
+  while (size < min_size)
+    size *= 2;
+  s->next_chunk_size = size * 2;
+
+  scratch_chunk *const c = memory_alloc(sizeof(scratch_chunk) + size);
+  *c = (scratch_chunk){.size = size};
+  s->chunk_count++;
+  atomic_fetch_add_explicit(&scratch_totals.chunks, 1, memory_order_relaxed);
+  return c;
+}
+
+// chunk_size 0 -> SCRATCH_DEFAULT_CHUNK_SIZE. the first chunk is allocated right away
+static inline void scratch_create(scratch *const s, const size_t chunk_size) {
+  *s = (scratch){.next_chunk_size = chunk_size ? chunk_size : SCRATCH_DEFAULT_CHUNK_SIZE};
+  s->first = s->current = scratch_chunk_create(s, 0);
+}
+
+static inline void scratch_destroy(scratch *const s) {
+  scratch_unaccount(s->in_use);
+  for (scratch_chunk *c = s->first; c;) {
+    scratch_chunk *const next = c->next;
+    memory_free(c);
+    c = next;
+  }
+  *s = (scratch){0};
+}
+
+// alignment has to be a power of two and at most 64
+static inline void *scratch_alloc(scratch *const s, const size_t size, const size_t alignment) {
+  tlbt_assert_fmt(alignment > 0 && alignment <= 64 && (alignment & (alignment - 1)) == 0,
+                  "unsupported alignment %zu", alignment);
+  scratch_chunk *c = s->current;
+  for (;;) {
+    const size_t offset = (c->used + alignment - 1) & ~(alignment - 1);
+    if (offset <= c->size && size <= c->size - offset) {
+      const size_t bytes = offset + size - c->used;
+      c->used = offset + size;
+      s->in_use += bytes;
+      if (s->in_use > s->high_water)
+        s->high_water = s->in_use;
+      scratch_account(bytes);
+      return c->data + offset;
+    }
+    // the leftover of the full chunk is lost until the next reset
+    if (!c->next)
+      c->next = scratch_chunk_create(s, size);
+    c = s->current = c->next;
+    c->used = 0;
+  }
+}
+
+#define scratch_new(s, type, count) ((type *)scratch_alloc((s), sizeof(type) * (count), _Alignof(type)))
+
+static inline scratch_mark scratch_get_mark(const scratch *const s) {
+  return (scratch_mark){.chunk = s->current, .used = s->current->used, .in_use = s->in_use};
+}
+
+// everything allocated after the mark becomes reusable
+static inline void scratch_reset(scratch *const s, const scratch_mark m) {
+  scratch_unaccount(s->in_use - m.in_use);
+  s->current = m.chunk;
+  s->current->used = m.used;
+  s->in_use = m.in_use;
+}
+
+static inline void scratch_clear(scratch *const s) {
+  scratch_reset(s, (scratch_mark){.chunk = s->first});
+}
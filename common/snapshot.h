@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ext/toolbelt/src/assert.h"
+#include "fileutils.h"
+#include "hash.h"
+
+// parsed inputs on disk. a day which supports it writes the arrays its solver works on into a snapshot and can later
+// solve straight from the mapped file without parsing again, which keeps parse and solve costs apart when benchmarking
+// huge inputs
+//
+// layout: a header with up to SNAPSHOT_MAX_SECTIONS sections, then the sections, each one starting at a multiple of
+// SNAPSHOT_ALIGNMENT. the checksum covers everything after the header. a snapshot is only valid for the day and the
+// layout version it was written with and the element sizes have to match, so a changed struct is caught even if
+// somebody forgot to bump the layout
+//
+// the file gets mapped, so the sections are page aligned + a multiple of 64. snapshots which can't be mapped (pipes)
+// are read into a malloc buffer, which is still aligned enough for every struct the days store
+
+#define SNAPSHOT_MAGIC 0x0070616e73636f61ull // "aocsnap"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_MAX_SECTIONS 8
+#define SNAPSHOT_ALIGNMENT 64
+
+typedef struct snapshot_section {
+  uint64_t offset; // from the start of the file
+  uint64_t size;
+  uint32_t element_size;
+  uint32_t reserved;
+} snapshot_section;
+
+typedef struct snapshot_header {
+  uint64_t magic;
+  uint32_t version; // of this container format
+  uint32_t day;
+  uint32_t layout; // day specific. bumped when a day changes what it stores
+  uint32_t section_count;
+  uint64_t payload_size; // everything after the header
+  uint64_t checksum;     // xxh64 of the payload
+  uint64_t reserved[3];
+  snapshot_section sections[SNAPSHOT_MAX_SECTIONS];
+} snapshot_header;
+
+_Static_assert(sizeof(snapshot_header) % SNAPSHOT_ALIGNMENT == 0, "sections have to start aligned");
+
+// collects the sections. they aren't copied until snapshot_write, so they have to stay alive until then
+typedef struct snapshot_writer {
+  const void *data[SNAPSHOT_MAX_SECTIONS];
+  snapshot_section sections[SNAPSHOT_MAX_SECTIONS];
+  uint32_t section_count;
+} snapshot_writer;
+
+typedef struct snapshot {
+  fileutils_mapping file;
+  const snapshot_header *header;
+} snapshot;
+
+static inline void snapshot_add(snapshot_writer *const w, const void *const data, const uint64_t count,
+                                const uint32_t element_size) {
+  tlbt_assert_fmt(w->section_count < SNAPSHOT_MAX_SECTIONS, "too many snapshot sections. max: %u",
+                  SNAPSHOT_MAX_SECTIONS);
+  w->data[w->section_count] = data;
+  w->sections[w->section_count] = (snapshot_section){.size = count * element_size, .element_size = element_size};
+  w->section_count++;
+}
+
+static inline uint64_t snapshot_align(const uint64_t offset) {
+  return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(uint64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+static inline bool snapshot_write(const snapshot_writer *const w, const char *const file_name, const uint32_t day,
+                                  const uint32_t layout) {
+  snapshot_header h = {.magic = SNAPSHOT_MAGIC,
+                       .version = SNAPSHOT_VERSION,
+                       .day = day,
+                       .layout = layout,
+                       .section_count = w->section_count};
+  uint64_t end = sizeof(h);
+  for (uint32_t i = 0; i < w->section_count; ++i) {
+    h.sections[i] = w->sections[i];
+    h.sections[i].offset = snapshot_align(end);
+    end = h.sections[i].offset + h.sections[i].size;
+  }
+  h.payload_size = snapshot_align(end) - sizeof(h);
+
+  // padding included, so the checksum covers every byte after the header
+  char *const payload = calloc(1, h.payload_size + 1);
+  for (uint32_t i = 0; i < w->section_count; ++i)
+    memcpy(payload + h.sections[i].offset - sizeof(h), w->data[i], h.sections[i].size);
+  h.checksum = hash_xxh64(payload, h.payload_size, 0);
+
+  FILE *f = fopen(file_name, "wb");
+  bool written = f && fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(payload, 1, h.payload_size, f) == h.payload_size;
+  if (f)
+    written &= fclose(f) == 0;
+  if (!written)
+    fprintf(stderr, "couldn't write snapshot '%s'\n", file_name);
+  free(payload);
+  return written;
+}
+
+static inline bool snapshot_open(snapshot *const s, const char *const file_name, const uint32_t day,
+                                 const uint32_t layout) {
+  *s = (snapshot){0};
+  if (!fileutils_map(file_name, &s->file))
+    return false;
+
+  const char *error = NULL;
+  const size_t size = s->file.length - 1;
+  const snapshot_header *const h = (const snapshot_header *)s->file.data;
+  if (size < sizeof(*h) || h->magic != SNAPSHOT_MAGIC)
+    error = "not a snapshot";
+  else if (h->version != SNAPSHOT_VERSION)
+    error = "unsupported snapshot version";
+  else if (h->day != day)
+    error = "snapshot of another day";
+  else if (h->layout != layout)
+    error = "snapshot layout is outdated";
+  else if (h->section_count > SNAPSHOT_MAX_SECTIONS || h->payload_size != size - sizeof(*h))
+    error = "snapshot is truncated or corrupt";
+  for (uint32_t i = 0; !error && i < h->section_count; ++i) {
+    const snapshot_section *const section = &h->sections[i];
+    if (section->offset < sizeof(*h) || section->offset % SNAPSHOT_ALIGNMENT != 0 || section->offset > size ||
+        section->size > size - section->offset || section->element_size == 0 ||
+        section->size % section->element_size != 0)
+      error = "snapshot section out of bounds";
+  }
+  if (!error && hash_xxh64(s->file.data + sizeof(*h), h->payload_size, 0) != h->checksum)
+    error = "snapshot checksum mismatch";
+
+  if (error) {
+    fprintf(stderr, "%s: %s\n", file_name, error);
+    fileutils_unmap(&s->file);
+    return false;
+  }
+  s->header = h;
+  return true;
+}
+
+static inline void snapshot_close(snapshot *const s) {
+  fileutils_unmap(&s->file);
+  s->header = NULL;
+}
+
+// the section as an array. NULL if it doesn't exist or holds elements of another size
+static inline const void *snapshot_section_data(const snapshot *const s, const uint32_t index,
+                                                const uint32_t element_size, uint64_t *const count) {
+  if (index >= s->header->section_count || s->header->sections[index].element_size != element_size)
+    return NULL;
+  *count = s->header->sections[index].size / element_size;
+  return s->file.data + s->header->sections[index].offset;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// timeline of the phases for chrome://tracing and ui.perfetto.dev. `--trace <file>` on a day records every phase and
+// section bench.h sees, once per entry instead of summed up, and writes them as trace events in the chrome json format.
+// chunks of pool_parallel_for/reduce are recorded too, on the thread which ran them, so the workers get their own
+// tracks
+//
+// events go into a buffer sized up front. recording is a single atomic increment and safe from any thread, everything
+// past the capacity is dropped and counted
+
+#define TRACE_DEFAULT_CAPACITY (256 * 1024)
+
+typedef struct trace_event {
+  const char *name; // not copied. string literals or names which outlive the trace
+  const char *category;
+  uint64_t start; // ns, CLOCK_MONOTONIC_RAW
+  uint64_t end;
+  uint32_t thread;
+} trace_event;
+
+typedef struct trace {
+  trace_event *events;
+  uint64_t capacity;
+  atomic_uint_fast64_t count; // can be bigger than capacity, the rest got dropped
+  uint64_t origin;            // timestamps in the file are relative to it
+} trace;
+
+// the trace everything records to. only set while tracing. weak so all translation units of the aoc runner share it
+__attribute__((weak)) trace *trace_active = NULL;
+
+static inline uint64_t trace_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// the kernel's thread id, like perf and gdb show it. the main thread has the id of the process
+static inline uint32_t trace_thread_id(void) {
+  static _Thread_local uint32_t id = 0;
+  if (id == 0)
+    id = (uint32_t)syscall(SYS_gettid);
+  return id;
+}
+
+static inline void trace_create(trace *const t, uint64_t capacity) {
+  if (capacity == 0)
+    capacity = TRACE_DEFAULT_CAPACITY;
+  *t = (trace){.events = malloc(sizeof(trace_event) * capacity), .capacity = capacity, .origin = trace_now()};
+  atomic_init(&t->count, 0);
+}
+
+static inline void trace_destroy(trace *const t) {
+  if (trace_active == t)
+    trace_active = NULL;
+  free(t->events);
+  *t = (trace){0};
+}
+
+static inline void trace_record(trace *const t, const char *const name, const char *const category,
+                                const uint64_t start, const uint64_t end) {
+  const uint64_t index = atomic_fetch_add_explicit(&t->count, 1, memory_order_relaxed);
+  if (index < t->capacity)
+    t->events[index] = (trace_event){
+        .name = name, .category = category, .start = start, .end = end, .thread = trace_thread_id()};
+}
+
+// for code which doesn't get the trace passed. start comes from trace_now
+static inline void trace_span(const char *const name, const char *const category, const uint64_t start) {
+  if (trace_active)
+    trace_record(trace_active, name, category, start, trace_now());
+}
+
+// complete events ("ph":"X") in microseconds. process_name is what the viewer shows above the tracks
+static inline bool trace_write(const trace *const t, const char *const file_name, const char *const process_name) {
+  FILE *f = fopen(file_name, "w");
+  if (!f) {
+    fprintf(stderr, "couldn't open file '%s'\n", file_name);
+    return false;
+  }
+  const uint32_t pid = (uint32_t)getpid();
+  const uint64_t recorded = atomic_load_explicit(&t->count, memory_order_relaxed);
+  const uint64_t count = recorded < t->capacity ? recorded : t->capacity;
+  fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", pid, pid,
+          process_name);
+  fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"main\"}}", pid, pid);
+  for (uint64_t i = 0; i < count; ++i) {
+    const trace_event *const e = &t->events[i];
+    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+            e->name, e->category, (e->start - t->origin) / 1000.0, (e->end - e->start) / 1000.0, pid, e->thread);
+  }
+  fprintf(f, "\n]}\n");
+  const bool written = fclose(f) == 0;
+  if (recorded > t->capacity)
+    fprintf(stderr, "trace full, dropped %lu of %lu events\n", recorded - t->capacity, recorded);
+  return written;
+}
@@ -1,90 +1,267 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
-#include "../common/fileutils.h"
-
-#define TLBT_T int16_t
-#define TLBT_T_NAME rot
-#define TLBT_DYNAMIC_MEMORY
-#define TLBT_BASE2_CAPACITY
-#define TLBT_STATIC
-#include "../ext/toolbelt/src/deque.h"
-
-static void parse_input(char *input, tlbt_deque_rot *const rots) {
-  for (;;) {
-    switch (*input) {
-    case 'L': {
-      const int16_t value = strtoul(input + 1, &input, 10);
-      tlbt_deque_rot_push_back(rots, -1 * value);
-      break;
-    }
-    case 'R': {
-      const int16_t value = strtoul(input + 1, &input, 10);
-      tlbt_deque_rot_push_back(rots, value);
-      break;
-    }
-    case '\n':
-      ++input;
-      break;
-    case '\0':
-      return;
+#include <stdlib.h>
+#include <string.h>
+#include "../common/aoc.h"
+#include "../common/fastint.h"
+#include "../common/pool.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
+#include "../ext/toolbelt/src/assert.h"
+
+#define DIAL_SIZE 100
+#define DIAL_START 50
+
+// inputs below this many bytes are simulated on one thread, splitting them costs more than it saves
+#define PARALLEL_MIN_LENGTH (256 * 1024)
+#define PARALLEL_MIN_CHUNK_LENGTH (64 * 1024)
+// chunks per thread, so a thread that got slow chunks doesn't hold up the others
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+// the rotations are applied while scanning the input, nothing but the dial is kept. memory stays the same no matter
+// how many lines there are
+typedef struct dial {
+  int32_t position;
+  uint64_t landed_on_zero;
+  uint64_t passed_zero;
+} dial;
+
+static inline void dial_rotate(dial *const d, int32_t rot) {
+  const int32_t from = d->position;
+  // int64, a rotation close to INT32_MAX would overflow the dial otherwise
+  const int64_t moved = (int64_t)from + rot;
+  const int32_t to = ((moved < 0 ? 100 : 0) + (moved % 100)) % 100;
+  rot = abs(rot);
+
+  if ((rot % 100) > 0) {
+    if (to == 0) {
+      d->landed_on_zero++;
+    } else if ((to > from && moved <= 0 && from != 0) || (from > to && moved > 99)) {
+      d->passed_zero++;
     }
   }
+  if (rot >= 100) {
+    d->passed_zero += (rot / 100);
+  }
+
+  d->position = to;
 }
 
-static void solve(tlbt_deque_rot *const rots, uint32_t *part1, uint32_t *part2) {
-  int16_t from, to;
-  int16_t dial = 50;
-  uint32_t landed_on_zero = 0;
-  uint32_t passed_zero = 0;
-
-  tlbt_deque_iterator_rot iter = {0};
-  tlbt_deque_iterator_rot_init(&iter, rots);
-
-  int16_t rot = 0;
-  while (tlbt_deque_iterator_rot_iterate(&iter, &rot)) {
-    from = dial;
-    dial += rot;
-    to = ((dial < 0 ? 100 : 0) + (dial % 100)) % 100;
-    rot = abs(rot);
-
-    if ((rot % 100) > 0) {
-      if (to == 0) {
-        landed_on_zero++;
-      } else if ((to > from && dial <= 0 && from != 0) || (from > to && dial > 99)) {
-        passed_zero++;
+// one line, without the new line. negative for 'L'
+static inline int32_t parse_rotation(const char *const line) {
+  tlbt_assert_fmt(*line == 'L' || *line == 'R', "expected 'L' or 'R', actual '%c' (%d)", *line, *line);
+  const uint64_t value = fastint_parse_u64(line + 1, NULL);
+  tlbt_assert_fmt(value <= INT32_MAX, "rotation too big. max: %d", INT32_MAX);
+  return *line == 'L' ? -(int32_t)value : (int32_t)value;
+}
+
+// end has to be the zero terminator or the start of a line
+static void simulate(const char *input, const char *const end, dial *const d) {
+  while (input < end) {
+    const char *line_end = scan_find(input, '\n');
+    if (line_end != input)
+      dial_rotate(d, parse_rotation(input));
+    input = line_end + (*line_end == '\n');
+  }
+}
+
+// what a chunk of rotations does to the dial for every position it could start at. the position before a chunk is only
+// known once all chunks before it ran, so every chunk is summarized on its own and the summaries are chained after.
+// that's the one sequential part, a few lookups per chunk
+//
+// with p the start and s the sum of the rotations so far, the dial is at (p + s) % 100. a rotation that doesn't leave
+// the dial where it was lands on zero if s % 100 == (100 - p) % 100, so counting the rotations per s % 100 is enough.
+// every rotation passes or lands on zero once per multiple of 100 it covers: (a, b] to the right, [b, a) to the left.
+// floor((p + x) / 100) = floor(x / 100) + (p >= 100 - x % 100), so the count splits into a part which doesn't depend on
+// p and steps at 100 - x % 100, which are kept as differences
+typedef struct dial_chunk {
+  const char *begin;
+  const char *end;
+  int32_t rotation; // sum of the rotations % 100
+  uint64_t landed_on_zero[DIAL_SIZE]; // by start position
+  uint64_t hit_zero[DIAL_SIZE];       // landed on or passed, by start position
+} dial_chunk;
+
+typedef struct hit_counts {
+  int64_t base;
+  int64_t steps[DIAL_SIZE]; // steps[p] changes the count for every start position >= p
+} hit_counts;
+
+// sign * floor((p + x) / 100) for every start position p
+static inline void hit_counts_add(hit_counts *const h, const int64_t x, const int64_t sign) {
+  const int64_t r = ((x % DIAL_SIZE) + DIAL_SIZE) % DIAL_SIZE;
+  h->base += sign * ((x - r) / DIAL_SIZE);
+  if (r != 0)
+    h->steps[DIAL_SIZE - r] += sign;
+}
+
+static void summarize_chunk(dial_chunk *const c) {
+  hit_counts h = {0};
+  uint64_t landed[DIAL_SIZE] = {0};
+  // sum of the rotations so far, % 100. adding whole turns to both ends of a rotation doesn't change how many
+  // multiples of 100 it covers, so s stays small
+  int64_t s = 0;
+  const char *input = c->begin;
+  while (input < c->end) {
+    const char *line_end = scan_find(input, '\n');
+    if (line_end != input) {
+      const int32_t rot = parse_rotation(input);
+      const int64_t to = s + rot;
+      if (rot > 0) {
+        hit_counts_add(&h, to, 1);
+        hit_counts_add(&h, s, -1);
+      } else if (rot < 0) {
+        hit_counts_add(&h, s - 1, 1);
+        hit_counts_add(&h, to - 1, -1);
       }
+      s = ((to % DIAL_SIZE) + DIAL_SIZE) % DIAL_SIZE;
+      if (rot % DIAL_SIZE != 0)
+        landed[s]++;
     }
-    if (rot >= 100) {
-      passed_zero += (rot / 100);
-    }
+    input = line_end + (*line_end == '\n');
+  }
 
-    dial = to;
+  c->rotation = (int32_t)s;
+  int64_t hits = h.base;
+  for (uint32_t p = 0; p < DIAL_SIZE; ++p) {
+    hits += h.steps[p];
+    c->hit_zero[p] = (uint64_t)hits;
+    c->landed_on_zero[p] = landed[(DIAL_SIZE - p) % DIAL_SIZE];
   }
+}
 
-  *part1 = landed_on_zero;
-  *part2 = passed_zero + landed_on_zero;
+static void summarize_chunks(void *arg, const uint64_t begin, const uint64_t end) {
+  dial_chunk *const chunks = arg;
+  for (uint64_t i = begin; i < end; ++i)
+    summarize_chunk(&chunks[i]);
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// the state of a dial which ran all rotations of the chunks, one after another
+static dial chain_chunks(const dial_chunk *const chunks, const uint32_t chunk_count) {
+  dial d = {.position = DIAL_START};
+  uint64_t hit_zero = 0;
+  for (uint32_t i = 0; i < chunk_count; ++i) {
+    d.landed_on_zero += chunks[i].landed_on_zero[d.position];
+    hit_zero += chunks[i].hit_zero[d.position];
+    d.position = (d.position + chunks[i].rotation) % DIAL_SIZE;
+  }
+  d.passed_zero = hit_zero - d.landed_on_zero;
+  return d;
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+// the chunks start at a line. the last one ends at the zero terminator
+static uint32_t split_input(const char *const input, const size_t length, dial_chunk *const chunks,
+                            const uint32_t max_chunks) {
+  const char *const end = input + length;
+  uint32_t count = 0;
+  const char *begin = input;
+  for (uint32_t i = 1; i <= max_chunks && begin < end; ++i) {
+    const char *split = i == max_chunks ? end : scan_find(input + length / max_chunks * i, '\n');
+    split += split < end;
+    if (split <= begin)
+      continue;
+    chunks[count++] = (dial_chunk){.begin = begin, .end = split};
+    begin = split;
+  }
+  return count;
+}
 
-  tlbt_deque_rot rots = {0};
-  tlbt_deque_rot_create(&rots, 4096);
-  parse_input(input, &rots);
-  free(input);
+// the chunk summaries live in the scratch
+typedef struct day_state {
+  scratch scratch;
+  dial d;
+} day_state;
 
-  uint32_t part1, part2;
-  solve(&rots, &part1, &part2);
+void *day01_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->scratch, 0);
+  return s;
+}
+
+void day01_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  free(s);
+}
 
-  tlbt_deque_rot_destroy(&rots);
+void day01_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  const char *const input = aoc_input(buffer, length);
+  const uint32_t thread_count = pool_self ? pool_self->p->thread_count + 1 : 1;
 
-  printf("%u %u\n", part1, part2);
+  // parsing and solving are one pass
+  bench_phase_begin(BENCH_PHASE_SOLVE);
+  if (thread_count == 1 || length < PARALLEL_MIN_LENGTH) {
+    s->d = (dial){.position = DIAL_START};
+    simulate(input, input + length, &s->d);
+  } else {
+    uint64_t max_chunks = length / PARALLEL_MIN_CHUNK_LENGTH;
+    if (max_chunks > thread_count * PARALLEL_CHUNKS_PER_THREAD)
+      max_chunks = thread_count * PARALLEL_CHUNKS_PER_THREAD;
+    scratch_clear(&s->scratch);
+    dial_chunk *const chunks = scratch_new(&s->scratch, dial_chunk, max_chunks);
+    const uint32_t chunk_count = split_input(input, length, chunks, (uint32_t)max_chunks);
+    pool_parallel_for(0, chunk_count, 1, summarize_chunks, chunks);
+    s->d = chain_chunks(chunks, chunk_count);
+  }
+  bench_phase_end(BENCH_PHASE_SOLVE);
+
+  *out = (aoc_result){
+      .part1 = s->d.landed_on_zero, .part2 = s->d.passed_zero + s->d.landed_on_zero, .part_count = 2};
 }
 
+AOC_DAY_DEFINE_SOLVE(day01)
+
+#ifndef AOC_LIBRARY
+// `day01 --all-starts <input>` prints both parts for every start position of the dial, one line each: start, part 1,
+// part 2. a chunk summary already has the counts for all of them, so the whole input as one chunk is a single pass
+// instead of 100
+static bool print_all_starts(const char *const file_name) {
+  fileutils_mapping input = {0};
+  if (!fileutils_map(file_name, &input))
+    return false;
+  const size_t length = input.length - 1;
+  const char *const begin = aoc_input(input.data, length);
+  dial_chunk c = {.begin = begin, .end = begin + length};
+  summarize_chunk(&c);
+  fileutils_unmap(&input);
+
+  for (uint32_t p = 0; p < DIAL_SIZE; ++p)
+    printf("%u %lu %lu\n", p, c.landed_on_zero[p], c.hit_zero[p]);
+  return true;
+}
+
+// `day01 --stream <input>` applies the rotations chunk by chunk while they are read, so memory stays the same no matter
+// how big the input is. "-" streams stdin, e.g. straight from build/gen/day01. it skips the cache and --bench, both of
+// them need the whole input
+static bool print_streamed(const aoc_day *const day, const char *const file_name) {
+  fileutils_reader r = {0};
+  if (!fileutils_reader_open(file_name, '\n', &r))
+    return false;
+  dial d = {.position = DIAL_START};
+  char *chunk = NULL;
+  size_t length = 0;
+  while (fileutils_reader_next(&r, &chunk, &length))
+    simulate(chunk, chunk + length - 1, &d);
+  fileutils_reader_close(&r);
+
+  const aoc_result result = {.part1 = d.landed_on_zero, .part2 = d.passed_zero + d.landed_on_zero, .part_count = 2};
+  aoc_print(stdout, day, &result);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const aoc_day day = AOC_DAY(day01);
+  for (int i = 1; i < argc; ++i) {
+    const bool all_starts = strcmp(argv[i], "--all-starts") == 0;
+    if (!all_starts && strcmp(argv[i], "--stream") != 0)
+      continue;
+    if (argc == 3 && i == 1)
+      return (all_starts ? print_all_starts(argv[2]) : print_streamed(&day, argv[2])) ? 0 : 1;
+    fprintf(stderr, "usage: %s %s <input>\n", argv[0], argv[i]);
+    return 1;
+  }
+  return aoc_main(argc, argv, &day);
+}
+#endif
@@ -1,8 +1,12 @@
 #include <ctype.h>
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
-#include "../common/fileutils.h"
+#include <stdlib.h>
+#include "../common/aoc.h"
+#include "../common/fastint.h"
+#include "../common/digits.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
 #include "../ext/toolbelt/src/assert.h"
 
 // biggest input number `grep -Po '[0-9]+' day02/input.txt | sort -nu | tail -n 1` -> 6_868_700_146
@@ -17,7 +21,7 @@ typedef struct range {
 #define TLBT_STATIC
 #include "../ext/toolbelt/src/deque.h"
 
-void parse_input(char *input, tlbt_deque_range *const ranges) {
+static void parse_input(char *input, tlbt_deque_range *const ranges) {
   for (;;) {
     switch (*input) {
     case '\0':
@@ -30,11 +34,11 @@ void parse_input(char *input, tlbt_deque_range *const ranges) {
     default: {
       range r = {0};
       tlbt_assert_fmt(isdigit(*input), "expected digit found '%c' (%d)", *input, *input);
-      r.from = strtoull(input, &input, 10);
+      r.from = fastint_parse_u64(input, &input);
       tlbt_assert_fmt(*input == '-', "expected `-` found `%c` (%d)", *input, *input);
       ++input; // skip minus
       tlbt_assert_fmt(isdigit(*input), "expected digit found '%c' (%d)", *input, *input);
-      r.to = strtoull(input, &input, 10);
+      r.to = fastint_parse_u64(input, &input);
       tlbt_deque_range_push_back(ranges, r);
       break;
     }
@@ -42,30 +46,13 @@ void parse_input(char *input, tlbt_deque_range *const ranges) {
   }
 }
 
-inline static uint32_t get_digit_count(const uint64_t n) {
-  return (uint32_t)log10(n) + 1;
-}
-
 inline static void subdivide(uint64_t input, uint64_t divisor, uint64_t digit_count, uint64_t *const output) {
   tlbt_assert_fmt(divisor > 1, "divisor should be bigger than 1 (actual: %lu)", divisor);
   tlbt_assert_fmt(divisor <= 6, "divisor should be smaller than 7 (actual: %lu)", divisor);
   tlbt_assert_fmt(digit_count % divisor == 0, "digit_count should be divisible by divisor (%lu %% %lu = %lu)",
                   digit_count, divisor, digit_count % divisor);
 
-  uint64_t groups = digit_count / divisor;
-  uint64_t divisor_pow = (uint64_t)pow(10, divisor);
-  for (int64_t i = groups - 1; i >= 0; --i) {
-    output[i] = input % divisor_pow;
-    input /= divisor_pow;
-  }
-}
-
-inline static uint64_t repeat(uint64_t input, uint64_t digit_count, uint64_t repetitions) {
-  uint64_t result = 0;
-  const uint64_t power = pow(10, digit_count);
-  for (uint64_t i = 0; i < repetitions; ++i)
-    result = result * power + input;
-  return result;
+  digits_split_u64(input, divisor, digit_count / divisor, output);
 }
 
 typedef struct divisor_values {
@@ -120,8 +107,8 @@ static uint64_t solve(tlbt_deque_range *const ranges, const divisor_values *cons
   while (tlbt_deque_iterator_range_iterate(&iter, &r)) {
     uint64_t from = r.from;
     uint64_t to = r.to;
-    uint32_t from_digit_count = get_digit_count(from);
-    uint32_t to_digit_count = get_digit_count(to);
+    uint32_t from_digit_count = digit_count_u64(from);
+    uint32_t to_digit_count = digit_count_u64(to);
 
     // theoretically ranges could go from a number with two digits smaller than the upper end. but I analyzed the input
     // and that's not the case. for example 100-10000
@@ -136,7 +123,7 @@ static uint64_t solve(tlbt_deque_range *const ranges, const divisor_values *cons
     if (from_digit_count != to_digit_count) {
       // this means something like 1000-20000
       // separate into two ranges like 1000-9999 and 10000-20000
-      new_ranges[0] = (range){from, pow(10, from_digit_count) - 1};
+      new_ranges[0] = (range){from, pow10_u64(from_digit_count) - 1};
       new_ranges[1] = (range){new_ranges[0].to + 1, to};
       new_range_count = 2;
     }
@@ -179,13 +166,13 @@ static uint64_t solve(tlbt_deque_range *const ranges, const divisor_values *cons
           subdivide(from, divisor, digit_count, subdivisions);
 
           uint64_t m = subdivisions[0] >= subdivisions[1] ? subdivisions[0] : subdivisions[0] + 1;
-          uint64_t current = repeat(m, group_digit_count, groups);
+          uint64_t current = digits_repeat_u64(m, group_digit_count, groups);
           while (current <= to) {
             if (current % ones[digit_count] != 0) {
               result += current;
             }
             m++;
-            current = repeat(m, group_digit_count, groups);
+            current = digits_repeat_u64(m, group_digit_count, groups);
           }
         }
       }
@@ -195,23 +182,53 @@ static uint64_t solve(tlbt_deque_range *const ranges, const divisor_values *cons
   return result;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
-
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+// the ranges live in the scratch. sized by the input, so the deque never has to grow
+typedef struct day_state {
+  scratch scratch;
+  tlbt_deque_range ranges;
+} day_state;
 
-  range buffer[32] = {0};
-  tlbt_deque_range ranges = {0};
-  tlbt_deque_range_init(&ranges, 32, buffer);
+void *day02_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->scratch, 0);
+  return s;
+}
 
-  parse_input(input, &ranges);
-  free(input);
+void day02_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  free(s);
+}
 
-  printf("%lu\n", solve(&ranges, divisors[0]));
-  printf("%lu\n", solve(&ranges, divisors[1]));
+void day02_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  tlbt_deque_range *const ranges = &s->ranges;
+
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  // the ranges are separated by ',' or a new line. base 2 for the deque
+  const uint64_t range_count = scan_count(input, ',') + scan_count(input, '\n') + 1;
+  size_t capacity = 16;
+  while (capacity < range_count)
+    capacity *= 2;
+  scratch_clear(&s->scratch);
+  tlbt_deque_range_init(ranges, capacity, scratch_new(&s->scratch, range, capacity));
+  parse_input(input, ranges);
+  bench_phase_end(BENCH_PHASE_PARSE);
+
+  out->part_count = 2;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  out->part1 = solve(ranges, divisors[0]);
+  bench_phase_end(BENCH_PHASE_PART1);
+  bench_phase_begin(BENCH_PHASE_PART2);
+  out->part2 = solve(ranges, divisors[1]);
+  bench_phase_end(BENCH_PHASE_PART2);
 }
 
+AOC_DAY_DEFINE_SOLVE(day02)
+
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day02));
+}
+#endif
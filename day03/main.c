@@ -1,24 +1,27 @@
 #include <ctype.h>
-#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/counters.h"
+#include "../common/digits.h"
+#include "../common/pool.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
 
-#define TLBT_IMPLEMENTATION
-#include "../ext/toolbelt/src/arena.h"
-
-// 200 lines with 100 digits each
-#define POWER_BANKS_MAX 200
-#define POWER_BANK_BATTERIES_MAX 100
+// 200 lines with 100 digits each. the banks are sized from the line count, the batteries of a bank from its line.
+// find_joltage indexes them with 32 bits
+#define POWER_BANK_BATTERIES_MAX UINT32_MAX
 
 typedef struct power_bank {
   uint8_t *batteries;
-  uint8_t count;
+  uint32_t count;
 } power_bank;
 
-static void parse_input(char *input, tlbt_arena *const a, power_bank *const banks, uint32_t *count) {
+// banks has room for one bank per line
+static void parse_input(char *input, scratch *const a, power_bank *const banks, uint32_t *count) {
   uint32_t c = 0;
   for (;;) {
     switch (*input) {
@@ -29,13 +32,16 @@ static void parse_input(char *input, tlbt_arena *const a, power_bank *const bank
       ++input;
       break;
     default: {
-      tlbt_assert_fmt(c + 1 <= POWER_BANKS_MAX, "there should not be more than %u power banks", POWER_BANKS_MAX);
+      const char *const line_end = scan_find(input, '\n');
+      // checked in release builds as well, the count would wrap around
+      if ((size_t)(line_end - input) > POWER_BANK_BATTERIES_MAX) {
+        fprintf(stderr, "there should not be more than %u batteries per power bank\n", POWER_BANK_BATTERIES_MAX);
+        exit(1);
+      }
       power_bank *b = &banks[c++];
       b->count = 0;
-      b->batteries = tlbt_arena_malloc(sizeof(uint8_t) * POWER_BANK_BATTERIES_MAX, a);
-      while (*input != '\0' && *input != '\n') {
-        tlbt_assert_fmt(b->count + 1 <= POWER_BANK_BATTERIES_MAX,
-                        "there should not be more than %u batteries per power bank", POWER_BANK_BATTERIES_MAX);
+      b->batteries = scratch_new(a, uint8_t, line_end - input);
+      while (input < line_end) {
         tlbt_assert_fmt(isdigit(*input), "expected digit (actual: '%c' (%d))", *input, *input);
         b->batteries[b->count++] = (*input) - '0';
         ++input;
@@ -46,13 +52,18 @@ static void parse_input(char *input, tlbt_arena *const a, power_bank *const bank
   }
 }
 
-static uint64_t find_joltage(const power_bank *const b, uint8_t index, const uint8_t count, uint8_t found) {
+AOC_COUNTER(find_joltage_calls, "day03 find_joltage calls")
+AOC_COUNTER_MAX(find_joltage_depth, "day03 find_joltage max depth")
+
+static uint64_t find_joltage(const power_bank *const b, uint32_t index, const uint8_t count, uint8_t found) {
+  AOC_COUNT(find_joltage_calls);
+  AOC_COUNT_MAX(find_joltage_depth, found + 1);
   for (uint8_t i = 9; i > 0; --i) {
     uint64_t joltage = 0;
-    for (uint8_t j = index; j < b->count; ++j) {
+    for (uint32_t j = index; j < b->count; ++j) {
       if (b->batteries[j] == i) {
         found++;
-        joltage = (uint64_t)pow(10, count - found) * (uint64_t)b->batteries[j];
+        joltage = pow10_u64(count - found) * (uint64_t)b->batteries[j];
         if (found == count) {
           return joltage;
         } else {
@@ -72,37 +83,68 @@ static uint64_t find_joltage(const power_bank *const b, uint8_t index, const uin
   return 0;
 }
 
-uint64_t solve(const power_bank *banks, const uint32_t bank_count, const uint8_t digits) {
+typedef struct solve_args {
+  const power_bank *banks;
+  uint8_t digits;
+} solve_args;
+
+static uint64_t solve_banks(void *arg, const uint64_t begin, const uint64_t end) {
+  const solve_args *const args = arg;
   uint64_t solution = 0;
-  for (uint32_t i = 0; i < bank_count; ++i) {
-    const power_bank *b = &banks[i];
-    solution += find_joltage(b, 0, digits, 0);
+  for (uint64_t i = begin; i < end; ++i) {
+    const power_bank *b = &args->banks[i];
+    solution += find_joltage(b, 0, args->digits, 0);
   }
   return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// the banks are independent. 16 per chunk, a single one is too little work to be worth a task
+static uint64_t solve(const power_bank *banks, const uint32_t bank_count, const uint8_t digits) {
+  solve_args args = {.banks = banks, .digits = digits};
+  return pool_parallel_reduce(0, bank_count, 16, solve_banks, &args, pool_sum, 0);
+}
+
+typedef struct day_state {
+  scratch a;
+  power_bank *banks; // one per line. parse_input sets every field of the banks it uses
+} day_state;
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+void *day03_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->a, 0);
+  return s;
+}
+
+void day03_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->a);
+  free(s);
+}
 
-  tlbt_arena a = {0};
-  tlbt_arena_create(21000, &a); // roughly 200*100*1=20000. add some extra for padding
+void day03_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  scratch_clear(&s->a);
 
-  power_bank banks[POWER_BANKS_MAX] = {0};
   uint32_t count = 0;
-  parse_input(input, &a, banks, &count);
-  free(input);
-
-  uint64_t part1 = solve(banks, count, 2);
-  uint64_t part2 = solve(banks, count, 12);
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  s->banks = scratch_new(&s->a, power_bank, scan_count(input, '\n') + 1);
+  parse_input(input, &s->a, s->banks, &count);
+  bench_phase_end(BENCH_PHASE_PARSE);
 
-  printf("%lu\n", part1);
-  printf("%lu\n", part2);
-  tlbt_arena_destroy(&a);
+  out->part_count = 2;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  out->part1 = solve(s->banks, count, 2);
+  bench_phase_end(BENCH_PHASE_PART1);
+  bench_phase_begin(BENCH_PHASE_PART2);
+  out->part2 = solve(s->banks, count, 12);
+  bench_phase_end(BENCH_PHASE_PART2);
 }
 
+AOC_DAY_DEFINE_SOLVE(day03)
+
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day03));
+}
+#endif
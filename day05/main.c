@@ -1,17 +1,17 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/fastint.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
 
-// grep -P '\d+-' day05/input.txt | wc -l
-// 174 ranges in my input. go with 200 for max size just in case
-#define MAX_RANGE_COUNT 200
-
-// grep -P '^\d+$' day05/input.txt | wc -l
-// 1000 ids in my input. assume it's the max
-#define MAX_ID_COUNT 1000
+// grep -P '\d+-' day05/input.txt | wc -l -> 174 ranges
+// grep -P '^\d+$' day05/input.txt | wc -l -> 1000 ids
+// both arrays get one slot per line of the input, there can't be more of either
 
 // grep -Po '\d+' day05/input.txt | sort -nu | tail -n 1
 // biggest number in my input is 562421429314384. definitely need a 64 bit int for that
@@ -27,6 +27,11 @@ static inline int64_t range_compare(const range left, const range right) {
   return from_diff != 0 ? from_diff : to_diff;
 }
 
+static int range_qsort_compare(const void *left, const void *right) {
+  const int64_t diff = range_compare(*(const range *)left, *(const range *)right);
+  return (diff > 0) - (diff < 0);
+}
+
 #ifndef NDEBUG
 #define assert_sorted_ranges(ranges, count)                                                                            \
   do {                                                                                                                 \
@@ -42,58 +47,56 @@ static inline int64_t range_compare(const range left, const range right) {
 #define assert_sorted_ranges(ranges, count)
 #endif
 
-void parse_input(char *input, range *const ranges, uint32_t *const range_count, int64_t *const ids,
-                 uint32_t *const id_count) {
+// the ranges, an empty line, then the ids. capacity is the size of both arrays
+static void parse_input(char *input, range *const ranges, uint32_t *const range_count, int64_t *const ids,
+                        uint32_t *const id_count, const uint64_t capacity) {
   uint32_t rc = 0;
   uint32_t ic = 0;
-  while (*input != '\n') {
-    tlbt_assert_fmt(rc + 1 <= MAX_RANGE_COUNT, "too many ranges. max: %u", MAX_RANGE_COUNT);
+  while (*input != '\0') {
+    char *line_end = scan_find(input, '\n');
+    if (line_end == input) {
+      // empty line. the ids start now
+      ++input;
+      break;
+    }
+    tlbt_assert_fmt(*line_end == '\n', "new line expected, actual '%c' (%d)", *line_end, *line_end);
+    tlbt_assert_fmt(rc + 1 <= capacity, "too many ranges. max: %lu", capacity);
     tlbt_assert_fmt(isdigit(*input), "digit expected, actual '%c' (%d)", *input, *input);
+    char *dash = scan_find(input, '-');
+    tlbt_assert_fmt(dash < line_end, "'-' expected before the end of the line, actual '%c' (%d)", *dash, *dash);
+    tlbt_assert_fmt(isdigit(*(dash + 1)), "digit expected, actual '%c' (%d)", *(dash + 1), *(dash + 1));
+    char *end = NULL;
     range r = {0};
-    r.from = strtoul(input, &input, 10);
-    tlbt_assert_fmt(*input == '-', "'-' expected, actual '%c' (%d)", *input, *input);
-    tlbt_assert_fmt(isdigit(*(input + 1)), "digit expected, actual '%c' (%d)", *input, *input);
-    r.to = strtoul(input + 1, &input, 10);
+    r.from = fastint_parse_u64(input, &end);
+    tlbt_assert_fmt(end == dash, "'-' expected, actual '%c' (%d)", *end, *end);
+    r.to = fastint_parse_u64(dash + 1, &end);
+    tlbt_assert_fmt(end == line_end, "new line expected, actual '%c' (%d)", *end, *end);
 
-    uint32_t current = rc;
+    // sorted once all are parsed. bubbling every new range into place is quadratic in the range count
     ranges[rc++] = r;
 
-    // bubble new range up so I don't have to sort later
-    for (int i = current; i > 0; --i) {
-      if (range_compare(ranges[i - 1], ranges[i]) > 0) {
-        range tmp = ranges[i];
-        ranges[i] = ranges[i - 1];
-        ranges[i - 1] = tmp;
-      }
-    }
-
-    tlbt_assert_fmt(*input == '\n', "new line expected, actual '%c' (%d)", *input, *input);
-    ++input; // skip new line
-    // either the next id range starts now or another new line. if it's a new line, then it will break out of this loop
+    input = line_end + 1;
+    // either the next id range starts now or another new line. if it's a new line, then the ids start
   }
 
-  for (;;) {
-    switch (*input) {
-    case '\0':
-      *range_count = rc;
-      *id_count = ic;
-      return;
-    case '\n':
-      ++input;
-      break;
-    default: {
-      tlbt_assert_fmt(ic + 1 <= MAX_ID_COUNT, "too many ids. max: %u", MAX_ID_COUNT);
+  while (*input != '\0') {
+    char *line_end = scan_find(input, '\n');
+    if (line_end != input) {
+      tlbt_assert_fmt(ic + 1 <= capacity, "too many ids. max: %lu", capacity);
       tlbt_assert_fmt(isdigit(*input), "digit expected, actual '%c' (%d)", *input, *input);
-      ids[ic++] = strtoul(input, &input, 10);
-      tlbt_assert_fmt(*input == '\n' || *input == '\0', "new line or zero terminator expected, actual '%c' (%d)",
-                      *input, *input);
-      break;
-    }
+      char *end = NULL;
+      ids[ic++] = fastint_parse_u64(input, &end);
+      tlbt_assert_fmt(end == line_end, "new line or zero terminator expected, actual '%c' (%d)", *end, *end);
     }
+    input = line_end + (*line_end == '\n');
   }
+
+  *range_count = rc;
+  *id_count = ic;
 }
 
 static uint32_t merge_ranges(range *const ranges, uint32_t range_count) {
+  qsort(ranges, range_count, sizeof(range), range_qsort_compare);
   assert_sorted_ranges(ranges, range_count);
   uint32_t merged = 0;
   uint32_t left = 0;
@@ -115,34 +118,35 @@ static uint32_t merge_ranges(range *const ranges, uint32_t range_count) {
     }
   }
 
-  // remove the empty slots ("sort")
-  const uint32_t new_count = range_count - merged;
-  for (uint32_t i = 0; i < new_count; ++i) {
-    if (ranges[i].from == INT64_MAX) {
-      for (uint32_t j = i + 1; j < range_count; ++j) {
-        if (ranges[j].from != INT64_MAX) {
-          ranges[i] = ranges[j];
-          ranges[j].from = INT64_MAX;
-          break;
-        }
-      }
-    }
+  // remove the empty slots. the ranges left keep their order
+  uint32_t new_count = 0;
+  for (uint32_t i = 0; i < range_count; ++i) {
+    if (ranges[i].from != INT64_MAX)
+      ranges[new_count++] = ranges[i];
   }
+  tlbt_assert(new_count == range_count - merged);
 
   return new_count;
 }
 
+// the merged ranges are sorted and don't overlap, so only the last range starting at or before the id can contain it
 static uint32_t solve_part1(const range *const ranges, const uint32_t range_count, const int64_t *const ids,
                             const uint32_t id_count) {
   uint32_t solution = 0;
 
   for (uint32_t i = 0; i < id_count; ++i) {
-    for (uint32_t j = 0; j < range_count; ++j) {
-      if (ids[i] >= ranges[j].from && ids[i] <= ranges[j].to) {
-        solution++;
-        break;
-      }
+    // first range starting after the id
+    uint32_t low = 0;
+    uint32_t high = range_count;
+    while (low < high) {
+      const uint32_t middle = low + (high - low) / 2;
+      if (ranges[middle].from <= ids[i])
+        low = middle + 1;
+      else
+        high = middle;
     }
+    if (low > 0 && ids[i] <= ranges[low - 1].to)
+      solution++;
   }
 
   return solution;
@@ -158,29 +162,71 @@ static uint64_t solve_part2(const range *const ranges, const uint32_t range_coun
   return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// both parts only read the merged ranges, so they can run at the same time
+typedef struct parts {
+  const range *ranges;
+  uint32_t range_count;
+  const int64_t *ids;
+  uint32_t id_count;
+  aoc_result *out;
+} parts;
+
+static void part1_task(void *arg) {
+  parts *const p = arg;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  p->out->part1 = solve_part1(p->ranges, p->range_count, p->ids, p->id_count);
+  bench_phase_end(BENCH_PHASE_PART1);
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+static void part2_task(void *arg) {
+  parts *const p = arg;
+  bench_phase_begin(BENCH_PHASE_PART2);
+  p->out->part2 = solve_part2(p->ranges, p->range_count);
+  bench_phase_end(BENCH_PHASE_PART2);
+}
 
-  uint32_t range_count = 0;
-  uint32_t id_count = 0;
-  range ranges[MAX_RANGE_COUNT] = {0};
-  int64_t ids[MAX_ID_COUNT] = {0};
+// parse_input only reads what it wrote itself, so nothing has to be zeroed between inputs
+typedef struct day_state {
+  scratch scratch;
+  range *ranges;
+  int64_t *ids;
+} day_state;
+
+void *day05_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->scratch, 0);
+  return s;
+}
 
-  parse_input(input, ranges, &range_count, ids, &id_count);
-  free(input);
+void day05_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  free(s);
+}
 
-  range_count = merge_ranges(ranges, range_count);
+void day05_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  uint32_t range_count, id_count;
+
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  const uint64_t capacity = scan_count(input, '\n') + 1;
+  scratch_clear(&s->scratch);
+  s->ranges = scratch_new(&s->scratch, range, capacity);
+  s->ids = scratch_new(&s->scratch, int64_t, capacity);
+  parse_input(input, s->ranges, &range_count, s->ids, &id_count, capacity);
+  range_count = merge_ranges(s->ranges, range_count);
+  bench_phase_end(BENCH_PHASE_PARSE);
+
+  out->part_count = 2;
+  parts p = {.ranges = s->ranges, .range_count = range_count, .ids = s->ids, .id_count = id_count, .out = out};
+  aoc_fork_parts(part1_task, &p, part2_task, &p);
+}
 
-  uint32_t part1 = solve_part1(ranges, range_count, ids, id_count);
-  uint64_t part2 = solve_part2(ranges, range_count);
+AOC_DAY_DEFINE_SOLVE(day05)
 
-  printf("%u\n", part1);
-  printf("%lu\n", part2);
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day05));
 }
-
+#endif
@@ -1,17 +1,21 @@
 #include <ctype.h>
-#include <math.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/digits.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
+#include "../common/snapshot.h"
 
 // awk '{print NF}' day06/input.txt | sort -u | tail -n 1
-// -> 1000 numbers per line
-#define MAX_TOKENS_PER_LINE 2001 // with spaces in between
+// -> 1000 numbers per line. the tokens of a line are sized from its length, the equations from the token count
 
 // wc -l
-// -> 5 lines (4 number lines, 1 operator line)
+// -> 5 lines (4 number lines, 1 operator line). every equation stores one value per line
 #define MAX_LINES 5
 
 typedef enum equation_type {
@@ -46,16 +50,23 @@ typedef struct token {
 } token;
 
 typedef struct token_line {
-  token tokens[MAX_TOKENS_PER_LINE];
-  uint16_t count;
+  token *tokens;
+  uint32_t count;
 } token_line;
 
-void tokenize_input(char *input, token_line *const lines, uint16_t *const line_count) {
+// every character is at most one token, plus the space tokens added at the start and the end
+static inline void token_line_create(token_line *const line, const char *const input, scratch *const a) {
+  line->tokens = scratch_new(a, token, scan_find(input, '\n') - input + 2);
+  line->count = 0;
+}
+
+static void tokenize_input(char *input, token_line *const lines, uint16_t *const line_count, scratch *const a) {
   uint16_t line = 0;
   uint32_t i = 0;
 
   // prepend a space token on every line with a length of 1
   // do it for the first line here
+  token_line_create(&lines[0], input, a);
   lines[0].tokens[i].type = TOKEN_TYPE_SPACE;
   lines[0].tokens[i++].length = 1;
 
@@ -80,7 +91,9 @@ void tokenize_input(char *input, token_line *const lines, uint16_t *const line_c
       lines[line].count = i;
       ++line;
       if (*input != '\0') {
+        tlbt_assert_fmt(line < MAX_LINES, "too many lines. max: %u", MAX_LINES);
         i = 0;
+        token_line_create(&lines[line], input, a);
         lines[line].tokens[i].type = TOKEN_TYPE_SPACE;
         lines[line].tokens[i++].length = 1;
       }
@@ -135,20 +148,21 @@ static bool parse_number(char *input, uint16_t *forward, uint16_t *backward) {
   uint16_t fwd = 0;
   uint16_t bwd = 0;
   for (size_t i = 0; i < len; ++i) {
-    fwd += (start[i] - '0') * (uint16_t)pow(10, len - i - 1);
-    bwd += (start[i] - '0') * (uint16_t)pow(10, i);
+    fwd = fwd * 10 + (start[i] - '0');
+    bwd += (start[i] - '0') * (uint16_t)pow10_u64(i);
   }
   *forward = fwd;
   *backward = bwd;
   return true;
 }
 
+// equations has room for half the tokens of a line
 static void parse_tokens(token_line *const lines, const uint8_t line_count, equation *const equations,
-                         uint16_t *const equation_count) {
+                         uint32_t *const equation_count) {
 #ifndef NDEBUG
   {
     // assert that every line starts and ends with a space token and that all lines have the same length
-    uint16_t line_length = lines[0].count;
+    uint32_t line_length = lines[0].count;
     for (uint8_t i = 0; i < line_count; ++i) {
       tlbt_assert_msg(lines[i].tokens[0].type == TOKEN_TYPE_SPACE, "expected line to start with space token");
       tlbt_assert_msg(lines[i].tokens[lines[i].count - 1].type == TOKEN_TYPE_SPACE,
@@ -161,7 +175,7 @@ static void parse_tokens(token_line *const lines, const uint8_t line_count, equa
 
   const uint8_t operator_line_index = line_count - 1;
   const uint8_t line_count_wo_op_line = operator_line_index;
-  uint16_t line_length_wo_spaces = lines[0].count / 2;
+  uint32_t line_length_wo_spaces = lines[0].count / 2;
   *equation_count = line_length_wo_spaces;
   for (uint32_t i = 0; i < line_length_wo_spaces; ++i) {
     const uint32_t token_index = i * 2;
@@ -188,10 +202,10 @@ static void parse_tokens(token_line *const lines, const uint8_t line_count, equa
   }
 }
 
-static uint64_t solve_part1(const equation *const equations, const uint16_t equation_count,
+static uint64_t solve_part1(const equation *const equations, const uint32_t equation_count,
                             const uint8_t operand_count) {
   uint64_t solution = 0;
-  for (uint16_t i = 0; i < equation_count; ++i) {
+  for (uint32_t i = 0; i < equation_count; ++i) {
     if (equations[i].type == EQUATION_TYPE_ADD) {
       uint64_t r = 0;
       for (uint16_t j = 0; j < operand_count; ++j) {
@@ -209,13 +223,17 @@ static uint64_t solve_part1(const equation *const equations, const uint16_t equa
   return solution;
 }
 
-static uint64_t solve_part2(equation *const equations, const uint16_t equation_count, const uint8_t operand_count) {
+static uint64_t solve_part2(const equation *const equations, const uint32_t equation_count,
+                            const uint8_t operand_count) {
   uint64_t solution = 0;
 
-  for (uint16_t i = 0; i < equation_count; ++i) {
+  for (uint32_t i = 0; i < equation_count; ++i) {
     uint16_t n = 0;
-    // parsed the number both normally and in reverse order. depending on alignment use the reversed one
-    uint16_t *v = equations[i].alignment == EQUATION_ALIGNMENT_LEFT ? equations[i].reverse : equations[i].values;
+    // parsed the number both normally and in reverse order. depending on alignment use the reversed one. the digits get
+    // consumed, so work on a copy. part 1 reads the same equations at the same time
+    uint16_t v[MAX_LINES];
+    const bool left = equations[i].alignment == EQUATION_ALIGNMENT_LEFT;
+    memcpy(v, left ? equations[i].reverse : equations[i].values, sizeof(v));
 
     // code duplication is a bit annoying in this case but besides macros I'm not aware of any other zero cost
     // abstractions. can only hope on compiler optimizations but some are not aggressive enough. so macro it is
@@ -230,7 +248,7 @@ static uint64_t solve_part2(equation *const equations, const uint16_t equation_c
         if (digit == 0) {                                                                                              \
           n /= 10;                                                                                                     \
         } else {                                                                                                       \
-          n += digit * pow(10, operand_count - j - 1);                                                                 \
+          n += digit * pow10_u64(operand_count - j - 1);                                                               \
         }                                                                                                              \
       }                                                                                                                \
       if (n == 0)                                                                                                      \
@@ -251,29 +269,119 @@ static uint64_t solve_part2(equation *const equations, const uint16_t equation_c
   return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// both parts only read the equations, so they can run at the same time
+typedef struct parts {
+  const equation *equations;
+  uint32_t equation_count;
+  uint8_t operand_count;
+  aoc_result *out;
+} parts;
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+static void part1_task(void *arg) {
+  parts *const p = arg;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  p->out->part1 = solve_part1(p->equations, p->equation_count, p->operand_count);
+  bench_phase_end(BENCH_PHASE_PART1);
+}
 
-  token_line lines[MAX_LINES] = {0};
-  uint16_t line_count = 0;
-  tokenize_input(input, lines, &line_count);
+static void part2_task(void *arg) {
+  parts *const p = arg;
+  bench_phase_begin(BENCH_PHASE_PART2);
+  p->out->part2 = solve_part2(p->equations, p->equation_count, p->operand_count);
+  bench_phase_end(BENCH_PHASE_PART2);
+}
 
-  equation equations[MAX_TOKENS_PER_LINE / 2] = {0};
-  uint16_t equation_count = 0;
-  parse_tokens(lines, line_count, equations, &equation_count);
-  free(input);
+// 2000 tokens per line are ~100KB. the tokens and the equations come from the scratch. tokenize_input and parse_tokens
+// only read what they wrote for the current input, so none of it gets zeroed between inputs
+typedef struct day_state {
+  scratch scratch;
+  token_line lines[MAX_LINES];
+  equation *equations;
+} day_state;
 
+void *day06_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->scratch, 0);
+  return s;
+}
+
+void day06_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  free(s);
+}
+
+static void parse(day_state *const s, const char *const buffer, const size_t length, uint32_t *const equation_count,
+                  uint8_t *const operand_count) {
+  uint16_t line_count = 0;
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  scratch_clear(&s->scratch);
+  tokenize_input(aoc_input(buffer, length), s->lines, &line_count, &s->scratch);
+  s->equations = scratch_new(&s->scratch, equation, s->lines[0].count / 2);
+  parse_tokens(s->lines, line_count, s->equations, equation_count);
+  bench_phase_end(BENCH_PHASE_PARSE);
   // line_count - 1 because line_count included the operator_line
-  uint64_t part1 = solve_part1(equations, equation_count, line_count - 1);
-  uint64_t part2 = solve_part2(equations, equation_count, line_count - 1);
+  *operand_count = line_count - 1;
+}
 
-  printf("%lu\n", part1);
-  printf("%lu\n", part2);
+static void solve(const equation *const equations, const uint32_t equation_count, const uint8_t operand_count,
+                  aoc_result *const out) {
+  out->part_count = 2;
+  parts p = {.equations = equations, .equation_count = equation_count, .operand_count = operand_count, .out = out};
+  aoc_fork_parts(part1_task, &p, part2_task, &p);
 }
 
+void day06_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  uint32_t equation_count = 0;
+  uint8_t operand_count = 0;
+  parse(s, buffer, length, &equation_count, &operand_count);
+  solve(s->equations, equation_count, operand_count, out);
+}
+
+// the equations and the operand count. the tokens are only needed for parsing
+#define SNAPSHOT_LAYOUT 1
+
+bool day06_emit_snapshot(void *const state, const char *const buffer, const size_t length,
+                         const char *const file_name) {
+  day_state *const s = state;
+  uint32_t equation_count = 0;
+  uint8_t operand_count = 0;
+  parse(s, buffer, length, &equation_count, &operand_count);
+
+  snapshot_writer w = {0};
+  snapshot_add(&w, s->equations, equation_count, sizeof(equation));
+  snapshot_add(&w, &operand_count, 1, sizeof(operand_count));
+  return snapshot_write(&w, file_name, 6, SNAPSHOT_LAYOUT);
+}
+
+bool day06_solve_snapshot(void *const state, const char *const file_name, aoc_result *const out) {
+  (void)state;
+  snapshot snap;
+  bench_phase_begin(BENCH_PHASE_LOAD);
+  const bool opened = snapshot_open(&snap, file_name, 6, SNAPSHOT_LAYOUT);
+  bench_phase_end(BENCH_PHASE_LOAD);
+  if (!opened)
+    return false;
+
+  uint64_t equation_count = 0, one = 0;
+  const equation *const equations = snapshot_section_data(&snap, 0, sizeof(equation), &equation_count);
+  const uint8_t *const operand_count = snapshot_section_data(&snap, 1, sizeof(uint8_t), &one);
+  // the solvers index values[] with the operand count
+  const bool valid = equations && operand_count && one == 1 && *operand_count <= MAX_LINES &&
+                     equation_count <= UINT32_MAX;
+  if (!valid)
+    fprintf(stderr, "%s: unexpected sections\n", file_name);
+  else
+    solve(equations, equation_count, *operand_count, out);
+  snapshot_close(&snap);
+  return valid;
+}
+
+AOC_DAY_DEFINE_SOLVE(day06)
+
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY_WITH_SNAPSHOT(day06));
+}
+#endif
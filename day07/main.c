@@ -1,9 +1,12 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/counters.h"
+#include "../common/scratch.h"
 
 typedef struct point {
   int32_t x;
@@ -21,9 +24,12 @@ static inline bool point_equals(const point left, const point right) {
   return left.x == right.x && left.y == right.y;
 }
 
+AOC_COUNTER(hashmap_probes, "day07 hashmap probes")
+AOC_COUNTER(hashmap_inserts, "day07 hashmap inserts")
+
 #define TLBT_KEY_T point
 #define TLBT_HASH_FUNC(p) point_hash(p)
-#define TLBT_EQUALS_FUNC(l, r) point_equals(l, r)
+#define TLBT_EQUALS_FUNC(l, r) (AOC_COUNT(hashmap_probes), point_equals(l, r))
 #define TLBT_BASE2_CAPACITY
 #define TLBT_DYNAMIC_MEMORY
 #define TLBT_STATIC
@@ -40,17 +46,14 @@ typedef struct node {
 #define TLBT_VALUE_T node *
 #define TLBT_VALUE_T_NAME node
 #define TLBT_HASH_FUNC(n) point_hash(n)
-#define TLBT_EQUALS_FUNC(l, r) point_equals(l, r)
+#define TLBT_EQUALS_FUNC(l, r) (AOC_COUNT(hashmap_probes), point_equals(l, r))
 #define TLBT_BASE2_CAPACITY
 #define TLBT_DYNAMIC_MEMORY
 #define TLBT_STATIC
 #include "../ext/toolbelt/src/hashmap.h"
 
-#define TLBT_IMPLEMENTATION
-#include "../ext/toolbelt/src/arena.h"
-
 static void parse_input(char *input, point *const start, uint32_t *const height, tlbt_map_point_node *const nodes,
-                        tlbt_arena *const allocator) {
+                        scratch *const allocator) {
   uint32_t line = 0;
   uint32_t column = 0;
 
@@ -77,12 +80,13 @@ static void parse_input(char *input, point *const start, uint32_t *const height,
       ++input;
       break;
     case '^': {
-      node *n = tlbt_arena_malloc(sizeof(node), allocator);
+      node *n = scratch_new(allocator, node, 1);
       n->left = NULL;
       n->right = NULL;
       n->value = 0;
       n->coords.x = column;
       n->coords.y = line;
+      AOC_COUNT(hashmap_inserts);
       tlbt_map_point_node_insert(nodes, n->coords, n);
       ++column;
       ++input;
@@ -98,6 +102,7 @@ static void parse_input(char *input, point *const start, uint32_t *const height,
 static uint32_t count_part1(const node *const n, tlbt_set_point *const visited) {
   if (tlbt_set_point_contains(visited, n->coords))
     return 0;
+  AOC_COUNT(hashmap_inserts);
   tlbt_set_point_insert(visited, n->coords);
 
   return (n->left ? count_part1(n->left, visited) : 0) + (n->right ? count_part1(n->right, visited) : 0) + 1;
@@ -109,8 +114,8 @@ static uint64_t count_part2(node *const n) {
   return n->value;
 }
 
-static void solve(const point start, const uint32_t height, tlbt_map_point_node *const nodes, uint32_t *const part1,
-                  uint64_t *const part2) {
+static void solve(const point start, const uint32_t height, tlbt_map_point_node *const nodes,
+                  tlbt_set_point *const visited, uint32_t *const part1, uint64_t *const part2) {
   // build tree
   tlbt_map_iterator_point_node iter = {0};
   tlbt_map_iterator_point_node_init(&iter, nodes);
@@ -142,41 +147,57 @@ static void solve(const point start, const uint32_t height, tlbt_map_point_node
   node *root = NULL;
   tlbt_map_point_node_get(nodes, (point){start.x, start.y + 2}, &root);
 
-  tlbt_set_point visited = {0};
-  tlbt_set_point_create(&visited, 4096);
-  *part1 = count_part1(root, &visited);
+  *part1 = count_part1(root, visited);
   *part2 = count_part2(root);
-
-  tlbt_set_point_destroy(&visited);
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+typedef struct day_state {
+  scratch a;
+  tlbt_map_point_node nodes;
+  tlbt_set_point visited;
+} day_state;
+
+void *day07_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  *s = (day_state){0};
+  scratch_create(&s->a, 0);
+  tlbt_map_point_node_create(&s->nodes, 4096);
+  tlbt_set_point_create(&s->visited, 4096);
+  return s;
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+void day07_destroy(void *const state) {
+  day_state *const s = state;
+  tlbt_set_point_destroy(&s->visited);
+  tlbt_map_point_node_destroy(&s->nodes);
+  scratch_destroy(&s->a);
+  free(s);
+}
 
-  tlbt_arena a = {0};
-  tlbt_arena_create(60000, &a);
+void day07_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  scratch_clear(&s->a);
+  tlbt_map_point_node_clear(&s->nodes);
+  tlbt_set_point_clear(&s->visited);
 
   point start = {0};
   uint32_t height = 0;
-  tlbt_map_point_node nodes = {0};
-  tlbt_map_point_node_create(&nodes, 4096);
-  parse_input(input, &start, &height, &nodes, &a);
-  free(input);
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  parse_input(aoc_input(buffer, length), &start, &height, &s->nodes, &s->a);
+  bench_phase_end(BENCH_PHASE_PARSE);
 
   uint32_t part1 = 0;
   uint64_t part2 = 0;
-  solve(start, height, &nodes, &part1, &part2);
+  bench_phase_begin(BENCH_PHASE_SOLVE);
+  solve(start, height, &s->nodes, &s->visited, &part1, &part2);
+  bench_phase_end(BENCH_PHASE_SOLVE);
+  *out = (aoc_result){.part1 = part1, .part2 = part2, .part_count = 2};
+}
 
-  printf("%u\n", part1);
-  printf("%lu\n", part2);
+AOC_DAY_DEFINE_SOLVE(day07)
 
-  tlbt_map_point_node_destroy(&nodes);
-  tlbt_arena_destroy(&a);
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day07));
 }
-
+#endif
@@ -1,14 +1,17 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
-#include <math.h>
 #include <string.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/counters.h"
+#include "../common/dispatch.h"
+#include "../common/fastint.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
 
-// wc -l day08/input.txt -> 1000
-#define MAX_JUNCTION_BOXES 1000
+// wc -l day08/input.txt -> 1000 junction boxes. the points get one slot per line
 
 // grep -Po '\d+' day08/input.txt | sort -nu | tail -n 1 -> 32-99964
 typedef struct point {
@@ -17,38 +20,51 @@ typedef struct point {
   int32_t z;
 } point;
 
+// points has room for one per line
 static void parse_input(char *input, point *const points, uint32_t *point_count) {
-  uint32_t c = 0;
-  for (;;) {
-    switch (*input) {
-    case '\0':
-      *point_count = c;
-      return;
-    case '\n':
-      ++input;
-      break;
-    default: {
-      tlbt_assert_fmt(c < MAX_JUNCTION_BOXES, "too many junction boxes. max: %u", MAX_JUNCTION_BOXES);
+  uint32_t c = *point_count;
+  while (*input != '\0') {
+    char *line_end = scan_find(input, '\n');
+    if (line_end != input) {
       tlbt_assert_fmt(isdigit(*input), "expected digit, actual '%c' (%d)", *input, *input);
+      char *first = scan_find(input, ',');
+      tlbt_assert_fmt(first < line_end, "expected ',', actual '%c' (%d)", *first, *first);
+      char *second = scan_find(first + 1, ',');
+      tlbt_assert_fmt(second < line_end, "expected ',', actual '%c' (%d)", *second, *second);
+      char *end = NULL;
       point p = {0};
-      p.x = strtoul(input, &input, 10);
-      tlbt_assert_fmt(*input == ',', "expected ',', actual '%c' (%d)", *input, *input);
-      p.y = strtoul(input + 1, &input, 10);
-      tlbt_assert_fmt(*input == ',', "expected ',', actual '%c' (%d)", *input, *input);
-      p.z = strtoul(input + 1, &input, 10);
-      tlbt_assert_fmt(*input == '\0' || *input == '\n', "expected new line or zero terminator, actual '%c' (%d)",
-                      *input, *input);
+      p.x = fastint_parse_u64(input, &end);
+      tlbt_assert_fmt(end == first, "expected ',', actual '%c' (%d)", *end, *end);
+      p.y = fastint_parse_u64(first + 1, &end);
+      tlbt_assert_fmt(end == second, "expected ',', actual '%c' (%d)", *end, *end);
+      p.z = fastint_parse_u64(second + 1, &end);
+      tlbt_assert_fmt(end == line_end, "expected new line or zero terminator, actual '%c' (%d)", *end, *end);
       points[c++] = p;
-      break;
-    }
     }
+    input = line_end + (*line_end == '\n');
   }
+  *point_count = c;
+}
+
+// only used for ordering so the square root isn't needed. 3 * 99964^2 doesn't fit in 32 bits anymore
+static inline uint64_t point_distance_squared(const point a, const point b) {
+  const int64_t dx = a.x - b.x;
+  const int64_t dy = a.y - b.y;
+  const int64_t dz = a.z - b.z;
+  return (uint64_t)(dx * dx + dy * dy + dz * dz);
 }
 
-static uint32_t point_distance(const point a, const point b) {
-  return (uint32_t)sqrt(pow(a.x - b.x, 2) + pow(a.y - b.y, 2) + pow(a.z - b.z, 2));
+// distances from a to every point. the heap pushes can't be vectorized, computing one row of distances up front can
+static inline void distances_row_kernel(const point *const points, const uint32_t count, const point a,
+                                        uint64_t *const out) {
+  for (uint32_t i = 0; i < count; ++i)
+    out[i] = point_distance_squared(a, points[i]);
 }
 
+DISPATCH_KERNEL_VOID(distances_row,
+                     (const point *const points, const uint32_t count, const point a, uint64_t *const out),
+                     (points, count, a, out))
+
 static inline uint32_t point_hash(const point p) {
   uint32_t hash = 36591911;
   hash = ((hash << 5) + hash) + (uint32_t)p.x;
@@ -61,11 +77,16 @@ static inline bool point_equals(const point left, const point right) {
   return left.x == right.x && left.y == right.y && left.z == right.z;
 }
 
+AOC_COUNTER(hashmap_probes, "day08 hashmap probes")
+AOC_COUNTER(hashmap_inserts, "day08 hashmap inserts")
+AOC_COUNTER(heap_pushes, "day08 heap pushes")
+AOC_COUNTER(heap_pops, "day08 heap pops")
+
 #define TLBT_KEY_T point
 #define TLBT_VALUE_T uint32_t
 #define TLBT_VALUE_T_NAME circuit
 #define TLBT_HASH_FUNC(p) point_hash(p)
-#define TLBT_EQUALS_FUNC(l, r) point_equals(l, r)
+#define TLBT_EQUALS_FUNC(l, r) (AOC_COUNT(hashmap_probes), point_equals(l, r))
 #define TLBT_BASE2_CAPACITY
 #define TLBT_DYNAMIC_MEMORY
 #define TLBT_STATIC
@@ -74,16 +95,20 @@ static inline bool point_equals(const point left, const point right) {
 typedef struct connection {
   point a;
   point b;
-  uint32_t dist;
+  uint64_t dist; // squared
 } connection;
 
-inline static int connection_compare(const connection left, const connection right) {
-  return (int64_t)left.dist - (int64_t)right.dist;
+// pairs part 1 connects
+#define CONNECTION_COUNT 1000
+
+// longest first. the toolbelt only has min heaps, the flipped compare makes it a max heap
+inline static int connection_compare_longest(const connection left, const connection right) {
+  return (left.dist < right.dist) - (left.dist > right.dist);
 }
 
 #define TLBT_T connection
-#define TLBT_DYNAMIC_MEMORY
-#define TLBT_COMPARE(l, r) connection_compare(l, r)
+#define TLBT_T_NAME longest
+#define TLBT_COMPARE(l, r) connection_compare_longest(l, r)
 #define TLBT_STATIC
 #include "../ext/toolbelt/src/heap.h"
 
@@ -111,14 +136,17 @@ static int connect(const point a, const point b, tlbt_map_point_circuit *const m
     return -1; // circuit removed
   } else if (a_is_in_circuit && !b_is_in_circuit) {
     // add b to circuit of a
+    AOC_COUNT(hashmap_inserts);
     tlbt_map_point_circuit_insert(m, b, a_circuit);
     return 0; // no change in the amount of circuits
   } else if (!a_is_in_circuit && b_is_in_circuit) {
     // add a to circuit of b
+    AOC_COUNT(hashmap_inserts);
     tlbt_map_point_circuit_insert(m, a, b_circuit);
     return 0; // no change in the amount of circuits
   } else if (!a_is_in_circuit && !b_is_in_circuit) {
     // both in no circuit, create new one
+    AOC_COUNT_ADD(hashmap_inserts, 2);
     tlbt_map_point_circuit_insert(m, a, *next_circuit_id);
     tlbt_map_point_circuit_insert(m, b, *next_circuit_id);
     (*next_circuit_id)++;
@@ -128,84 +156,185 @@ static int connect(const point a, const point b, tlbt_map_point_circuit *const m
   return 0; // already part of the same circuit. no change
 }
 
-static void solve(const point *const points, const uint32_t point_count, const uint32_t connection_count,
-                  uint32_t *const part1, uint64_t *const part2) {
-  tlbt_map_point_circuit m = {0};
-  tlbt_map_point_circuit_create(&m, 1024);
-
-  uint32_t next_circuit_id = 0;
-
-  tlbt_min_heap_connection connections = {0};
-  tlbt_min_heap_connection_create(&connections, 500000);
-
-  for (uint32_t i = 0; i < point_count - 1; ++i) {
+// the connection_count shortest pairs, in no particular order. a max heap of them keeps the longest on top, so most
+// pairs are rejected with a single compare
+static uint32_t shortest_pairs(const point *const points, const uint32_t point_count, const uint32_t connection_count,
+                               connection *const shortest, scratch *const a) {
+  tlbt_min_heap_longest heap = {.data = shortest, .count = 0, .capacity = connection_count};
+  uint64_t *const distances = scratch_new(a, uint64_t, point_count);
+  for (uint32_t i = 0; i + 1 < point_count; ++i) {
     const point a = points[i];
-    for (uint32_t j = i + 1; j < point_count; ++j) {
-      const point b = points[j];
-      tlbt_min_heap_connection_push(&connections, (connection){.a = a, .b = b, .dist = point_distance(a, b)});
+    const uint32_t row_count = point_count - i - 1;
+    distances_row(points + i + 1, row_count, a, distances);
+    for (uint32_t j = 0; j < row_count; ++j) {
+      if (heap.count == connection_count && distances[j] >= heap.data[0].dist)
+        continue;
+      if (heap.count == connection_count) {
+        AOC_COUNT(heap_pops);
+        tlbt_min_heap_longest_pop(&heap);
+      }
+      AOC_COUNT(heap_pushes);
+      tlbt_min_heap_longest_push(&heap, (connection){.a = a, .b = points[i + 1 + j], .dist = distances[j]});
     }
   }
+  return heap.count;
+}
 
-  int32_t circuit_count = 0;
-  for (uint32_t i = 0; i < connection_count; ++i) {
-    connection c = {0};
-    tlbt_min_heap_connection_peek(&connections, &c);
-    circuit_count += connect(c.a, c.b, &m, &next_circuit_id);
-    tlbt_min_heap_connection_pop(&connections);
-  }
+// m has to be empty. the pairs and the circuit sizes come from the scratch
+static uint32_t solve_part1(const point *const points, const uint32_t point_count, uint32_t connection_count,
+                            tlbt_map_point_circuit *const m, scratch *const a) {
+  const uint64_t pair_count = (uint64_t)point_count * (point_count - (point_count > 0)) / 2;
+  if (connection_count > pair_count)
+    connection_count = pair_count;
+
+  bench_section_begin("shortest pairs");
+  connection *const shortest = scratch_new(a, connection, connection_count);
+  connection_count = shortest_pairs(points, point_count, connection_count, shortest, a);
+  bench_section_end("shortest pairs");
 
-  tlbt_assert_msg(next_circuit_id <= 512, "expected less than 512 circuit ids");
-  uint32_t circuit_id_counts[512] = {0};
+  // the circuits only depend on which pairs got connected, not on the order
+  bench_section_begin("connect part1");
+  uint32_t next_circuit_id = 0;
+  for (uint32_t i = 0; i < connection_count; ++i)
+    connect(shortest[i].a, shortest[i].b, m, &next_circuit_id);
+  bench_section_end("connect part1");
+
+  // at least the three circuits part 1 multiplies. missing ones count as 0 like before
+  const uint32_t circuit_id_count = next_circuit_id > 3 ? next_circuit_id : 3;
+  uint32_t *const circuit_id_counts = scratch_new(a, uint32_t, circuit_id_count);
+  memset(circuit_id_counts, 0, sizeof(uint32_t) * circuit_id_count);
 
   tlbt_map_iterator_point_circuit iter = {0};
-  tlbt_map_iterator_point_circuit_init(&iter, &m);
+  tlbt_map_iterator_point_circuit_init(&iter, m);
   point *p = NULL;
   uint32_t *circ = NULL;
   while (tlbt_map_iterator_point_circuit_iterate(&iter, &p, &circ)) {
     circuit_id_counts[*circ]++;
   }
 
-  qsort(circuit_id_counts, 512, sizeof(uint32_t), (__compar_fn_t)u32_compare);
+  qsort(circuit_id_counts, circuit_id_count, sizeof(uint32_t), (__compar_fn_t)u32_compare);
 
   uint32_t p1 = 1;
   for (uint32_t i = 0; i < 3; ++i) {
     p1 *= circuit_id_counts[i];
   }
-  *part1 = p1;
+  return p1;
+}
 
-  connection last_connection = {0};
-  for (uint32_t i = connection_count; i < connections.count && (circuit_count != 1 || m.count != point_count); ++i) {
-    tlbt_min_heap_connection_peek(&connections, &last_connection);
-    circuit_count += connect(last_connection.a, last_connection.b, &m, &next_circuit_id);
-    tlbt_min_heap_connection_pop(&connections);
+// brings the points which aren't in the tree yet closer if a is closer to them than anything in the tree so far.
+// closest_x is the x of the tree point they are closest to, the only thing part 2 needs of it
+static inline void relax_kernel(const point *const rest, const uint32_t count, const point a, uint64_t *const closest,
+                                int32_t *const closest_x) {
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint64_t d = point_distance_squared(a, rest[i]);
+    const bool closer = d < closest[i];
+    closest[i] = closer ? d : closest[i];
+    closest_x[i] = closer ? a.x : closest_x[i];
   }
+}
 
-  *part2 = (uint64_t)last_connection.a.x * (uint64_t)last_connection.b.x;
+DISPATCH_KERNEL_VOID(relax,
+                     (const point *const rest, const uint32_t count, const point a, uint64_t *const closest,
+                      int32_t *const closest_x),
+                     (rest, count, a, closest, closest_x))
+
+// connecting the pairs shortest first until everything is one circuit is kruskal's algorithm, the pair that finishes
+// it is the longest edge of the minimum spanning tree. prim's algorithm finds the same tree with a distance per point
+// instead of a heap of all pairs: n rounds over the points which aren't in the tree yet, O(n) memory
+static uint64_t solve_part2(const point *const points, const uint32_t point_count, scratch *const a) {
+  if (point_count < 2)
+    return 0;
+
+  bench_section_begin("spanning tree");
+  point *const rest = scratch_new(a, point, point_count);
+  uint64_t *const closest = scratch_new(a, uint64_t, point_count);
+  int32_t *const closest_x = scratch_new(a, int32_t, point_count);
+  memcpy(rest, points, sizeof(point) * point_count);
+  for (uint32_t i = 0; i < point_count; ++i)
+    closest[i] = UINT64_MAX;
+
+  // the tree starts with the last point. the rest get swapped to the back once they are in
+  uint32_t rest_count = point_count - 1;
+  point added = rest[rest_count];
+  uint64_t longest = 0;
+  uint64_t solution = 0;
+  while (rest_count > 0) {
+    relax(rest, rest_count, added, closest, closest_x);
+    uint32_t next = 0;
+    for (uint32_t i = 1; i < rest_count; ++i)
+      next = closest[i] < closest[next] ? i : next;
+    if (closest[next] >= longest) {
+      longest = closest[next];
+      solution = (uint64_t)closest_x[next] * (uint64_t)rest[next].x;
+    }
+    added = rest[next];
+    --rest_count;
+    rest[next] = rest[rest_count];
+    closest[next] = closest[rest_count];
+    closest_x[next] = closest_x[rest_count];
+  }
+  bench_section_end("spanning tree");
 
-  tlbt_min_heap_connection_destroy(&connections);
-  tlbt_map_point_circuit_destroy(&m);
+  return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// nothing grows with the square of the points anymore. the points and everything the parts need come from the
+// scratch, one slot per line for the points
+typedef struct day_state {
+  point *points;
+  tlbt_map_point_circuit m;
+  scratch scratch;
+} day_state;
+
+void *day08_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  s->m = (tlbt_map_point_circuit){0};
+  tlbt_map_point_circuit_create(&s->m, 1024);
+  scratch_create(&s->scratch, 0);
+  return s;
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+void day08_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  tlbt_map_point_circuit_destroy(&s->m);
+  free(s);
+}
 
-  uint32_t point_count = 0;
-  point points[MAX_JUNCTION_BOXES] = {0};
+void day08_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  tlbt_map_point_circuit_clear(&s->m);
 
-  parse_input(input, points, &point_count);
-  free(input);
+  uint32_t point_count = 0;
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  scratch_clear(&s->scratch);
+  s->points = scratch_new(&s->scratch, point, scan_count(input, '\n') + 1);
+  parse_input(input, s->points, &point_count);
+  // part 1 puts the points of its pairs into the map. big enough up front, so it doesn't rehash while connecting
+  const uint64_t circuit_points = point_count < 2 * CONNECTION_COUNT ? point_count : 2 * CONNECTION_COUNT;
+  if ((circuit_points + 1) * 4 > s->m.capacity * 3) {
+    size_t capacity = s->m.capacity;
+    while ((circuit_points + 1) * 4 > capacity * 3)
+      capacity *= 2;
+    tlbt_map_point_circuit_destroy(&s->m);
+    tlbt_map_point_circuit_create(&s->m, capacity);
+  }
+  bench_phase_end(BENCH_PHASE_PARSE);
+
+  out->part_count = 2;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  out->part1 = solve_part1(s->points, point_count, CONNECTION_COUNT, &s->m, &s->scratch);
+  bench_phase_end(BENCH_PHASE_PART1);
+  bench_phase_begin(BENCH_PHASE_PART2);
+  out->part2 = solve_part2(s->points, point_count, &s->scratch);
+  bench_phase_end(BENCH_PHASE_PART2);
+}
 
-  uint32_t part1 = 0;
-  uint64_t part2 = 0;
-  solve(points, point_count, 1000, &part1, &part2);
+AOC_DAY_DEFINE_SOLVE(day08)
 
-  printf("%u\n", part1);
-  printf("%lu\n", part2);
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day08));
 }
-
+#endif
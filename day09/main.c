@@ -1,12 +1,18 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/counters.h"
+#include "../common/dispatch.h"
+#include "../common/pool.h"
+#include "../common/fastint.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
 
-// wc -l day09/input.txt -> 497
-#define MAX_VERTICES 500
+// wc -l day09/input.txt -> 497 vertices. one slot per line for the points and for each kind of edge
 
 // grep -Po '\d+' day09/input.txt | sort -nur | tail -n 1 -> 98471
 typedef struct point {
@@ -14,30 +20,27 @@ typedef struct point {
   int32_t y;
 } point;
 
-void parse_input(char *input, point *const points, uint32_t *const point_count) {
-  uint32_t c = 0;
-  for (;;) {
-    switch (*input) {
-    case '\0':
-      *point_count = c;
-      return;
-    case '\n':
-      ++input;
-      break;
-    default:
-      tlbt_assert_fmt(c < MAX_VERTICES, "too many vertices. max: %u", MAX_VERTICES);
+// points has room for one per line
+static void parse_input(char *input, point *const points, uint32_t *const point_count) {
+  uint32_t c = *point_count;
+  while (*input != '\0') {
+    char *line_end = scan_find(input, '\n');
+    if (line_end != input) {
       tlbt_assert_fmt(isdigit(*input), "expected digit, actual '%c' (%d)", *input, *input);
+      char *comma = scan_find(input, ',');
+      tlbt_assert_fmt(comma < line_end, "expected ',', actual '%c' (%d)", *comma, *comma);
+      tlbt_assert_fmt(isdigit(*(comma + 1)), "expected digit, actual '%c' (%d)", *(comma + 1), *(comma + 1));
+      char *end = NULL;
       point p = {0};
-      p.x = strtoul(input, &input, 10);
-      tlbt_assert_fmt(*input == ',', "expected ',', actual '%c' (%d)", *input, *input);
-      tlbt_assert_fmt(isdigit(*(input + 1)), "expected digit, actual '%c' (%d)", *input, *input);
-      p.y = strtoul(input + 1, &input, 10);
-      tlbt_assert_fmt(*input == '\n' || *input == '\0', "expected new line or zero terminator, actual '%c' (%d)",
-                      *input, *input);
+      p.x = fastint_parse_u64(input, &end);
+      tlbt_assert_fmt(end == comma, "expected ',', actual '%c' (%d)", *end, *end);
+      p.y = fastint_parse_u64(comma + 1, &end);
+      tlbt_assert_fmt(end == line_end, "expected new line or zero terminator, actual '%c' (%d)", *end, *end);
       points[c++] = p;
-      break;
     }
+    input = line_end + (*line_end == '\n');
   }
+  *point_count = c;
 }
 
 static uint64_t solve_part1(const point *const points, const uint32_t point_count) {
@@ -81,6 +84,21 @@ static inline bool line_intersect(const edge a, const edge b) {
   return a.x > b.xmin && a.x < b.xmax && b.y > a.ymin && b.y < a.ymax;
 }
 
+AOC_COUNTER(line_intersect_calls, "day09 line_intersect calls")
+
+// how many of the edges the probe crosses. no early exit, so the compare chain vectorizes over the edges
+static inline uint32_t count_intersections_kernel(const edge *const edges, const uint32_t count, const edge probe) {
+  uint32_t intersections = 0;
+  for (uint32_t i = 0; i < count; ++i)
+    intersections += line_intersect(probe, edges[i]);
+  // once per kernel call, so the loop stays vectorized in the counters build as well
+  AOC_COUNT_ADD(line_intersect_calls, count);
+  return intersections;
+}
+
+DISPATCH_KERNEL(uint32_t, count_intersections, (const edge *const edges, const uint32_t count, const edge probe),
+                (edges, count, probe))
+
 static bool is_rect_inside(const rect r, const tlbt_deque_edge *const vertical_edges,
                            const tlbt_deque_edge *const horizontal_edges) {
   // top and bottom edge of the rectangle
@@ -95,17 +113,13 @@ static bool is_rect_inside(const rect r, const tlbt_deque_edge *const vertical_e
   };
 
   // check if rectangle edges intersect with any polygon edges
-  for (size_t i = 0; i < vertical_edges->count; ++i) {
-    if (line_intersect(hor_edges[0], vertical_edges->data[i]) ||
-        line_intersect(hor_edges[1], vertical_edges->data[i])) {
-      return false;
-    }
-  }
-  for (size_t i = 0; i < horizontal_edges->count; ++i) {
-    if (line_intersect(ver_edges[0], horizontal_edges->data[i]) ||
-        line_intersect(ver_edges[1], horizontal_edges->data[i])) {
-      return false;
-    }
+  const uint32_t vertical_count = vertical_edges->count;
+  const uint32_t horizontal_count = horizontal_edges->count;
+  if (count_intersections(vertical_edges->data, vertical_count, hor_edges[0]) > 0 ||
+      count_intersections(vertical_edges->data, vertical_count, hor_edges[1]) > 0 ||
+      count_intersections(horizontal_edges->data, horizontal_count, ver_edges[0]) > 0 ||
+      count_intersections(horizontal_edges->data, horizontal_count, ver_edges[1]) > 0) {
+    return false;
   }
 
   // now cast a ray to two sides of every point and see how many intersections they have. they all have to be odd
@@ -132,26 +146,12 @@ static bool is_rect_inside(const rect r, const tlbt_deque_edge *const vertical_e
   };
 
   for (uint32_t i = 0; i < 4; ++i) {
-    uint32_t intersections = 0;
-    for (size_t j = 0; j < horizontal_edges->count; ++j) {
-      if (line_intersect(vertical_rays[i], horizontal_edges->data[j])) {
-        // basically toggling from 0 to 1 etc
-        intersections ^= 1;
-      }
-    }
-    // if it's 0 (odd intersections) then another xor with 1 will result in 1 which is "true"
-    if (intersections ^ 1) {
+    if ((count_intersections(horizontal_edges->data, horizontal_count, vertical_rays[i]) & 1) == 0) {
       return false;
     }
   }
   for (uint32_t i = 0; i < 4; ++i) {
-    uint32_t intersections = 0;
-    for (size_t j = 0; j < vertical_edges->count; ++j) {
-      if (line_intersect(horizontal_rays[i], vertical_edges->data[j])) {
-        intersections ^= 1;
-      }
-    }
-    if (intersections ^ 1) {
+    if ((count_intersections(vertical_edges->data, vertical_count, horizontal_rays[i]) & 1) == 0) {
       return false;
     }
   }
@@ -159,16 +159,51 @@ static bool is_rect_inside(const rect r, const tlbt_deque_edge *const vertical_e
   return true;
 }
 
-static uint64_t solve_part2(const point *const points, const uint32_t point_count) {
+typedef struct pairs {
+  const point *points;
+  uint32_t point_count;
+  const tlbt_deque_edge *vertical_edges;
+  const tlbt_deque_edge *horizontal_edges;
+} pairs;
+
+// the rectangles spanned by point i and every later point, for i in [begin, end)
+static uint64_t biggest_inside_area(void *arg, const uint64_t begin, const uint64_t end) {
+  const pairs *const p = arg;
+  const point *const points = p->points;
   uint64_t biggest_area = 0;
+  for (uint32_t i = begin; i < end; ++i) {
+    for (uint32_t j = i + 1; j < p->point_count; ++j) {
+      rect r = {.left = MIN(points[i].x, points[j].x),
+                .top = MIN(points[i].y, points[j].y),
+                .right = MAX(points[i].x, points[j].x),
+                .bottom = MAX(points[i].y, points[j].y)};
+
+      // deflate rectangle by 1 for handling weird edge cases
+      rect r2 = {.left = r.left + 1, .top = r.top + 1, .right = r.right - 1, .bottom = r.bottom - 1};
+      if (r2.left > r2.right || r2.top > r2.bottom)
+        continue;
+
+      if (is_rect_inside(r2, p->vertical_edges, p->horizontal_edges)) {
+        const uint64_t width = (r.right - r.left) + 1;
+        const uint64_t height = (r.bottom - r.top) + 1;
+        const uint64_t area = width * height;
+        if (area > biggest_area) {
+          biggest_area = area;
+        }
+      }
+    }
+  }
+  return biggest_area;
+}
 
-  edge vert_edge_buffer[MAX_VERTICES / 2] = {0};
-  edge hor_edge_buffer[MAX_VERTICES / 2] = {0};
+// the edge buffers need room for point_count edges each
+static uint64_t solve_part2(const point *const points, const uint32_t point_count, edge *const vertical_buffer,
+                            edge *const horizontal_buffer) {
   tlbt_deque_edge vertical_edges = {0};
   tlbt_deque_edge horizontal_edges = {0};
 
-  tlbt_deque_edge_init(&vertical_edges, MAX_VERTICES / 2, vert_edge_buffer);
-  tlbt_deque_edge_init(&horizontal_edges, MAX_VERTICES / 2, hor_edge_buffer);
+  tlbt_deque_edge_init(&vertical_edges, point_count, vertical_buffer);
+  tlbt_deque_edge_init(&horizontal_edges, point_count, horizontal_buffer);
 
   for (uint32_t i = 0; i < point_count; ++i) {
     uint32_t j = (i + 1) % point_count;
@@ -187,51 +222,90 @@ static uint64_t solve_part2(const point *const points, const uint32_t point_coun
   tlbt_assert(vertical_edges.head == 0);
   tlbt_assert(horizontal_edges.head == 0);
 
-  for (uint32_t i = 0; i < point_count - 1; ++i) {
-    for (uint32_t j = i + 1; j < point_count; ++j) {
-      rect r = {.left = MIN(points[i].x, points[j].x),
-                .top = MIN(points[i].y, points[j].y),
-                .right = MAX(points[i].x, points[j].x),
-                .bottom = MAX(points[i].y, points[j].y)};
+  // the rows of the pair triangle get shorter with i. small chunks so the workers which got the short rows can steal
+  // from the others. timing every single is_rect_inside call would cost more than the call itself
+  pairs p = {.points = points,
+             .point_count = point_count,
+             .vertical_edges = &vertical_edges,
+             .horizontal_edges = &horizontal_edges};
+  bench_section_begin("is_rect_inside");
+  const uint64_t biggest_area = pool_parallel_reduce(0, point_count, 8, biggest_inside_area, &p, pool_max, 0);
+  bench_section_end("is_rect_inside");
 
-      // deflate rectangle by 1 for handling weird edge cases
-      rect r2 = {.left = r.left + 1, .top = r.top + 1, .right = r.right - 1, .bottom = r.bottom - 1};
-      if (r2.left > r2.right || r2.top > r2.bottom)
-        continue;
+  return biggest_area;
+}
 
-      if (is_rect_inside(r2, &vertical_edges, &horizontal_edges)) {
-        const uint64_t width = (r.right - r.left) + 1;
-        const uint64_t height = (r.bottom - r.top) + 1;
-        const uint64_t area = width * height;
-        if (area > biggest_area) {
-          biggest_area = area;
-        }
-      }
-    }
-  }
+// both parts only read the points, so they can run at the same time
+typedef struct parts {
+  const point *points;
+  uint32_t point_count;
+  edge *vertical_buffer;
+  edge *horizontal_buffer;
+  aoc_result *out;
+} parts;
+
+static void part1_task(void *arg) {
+  parts *const p = arg;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  p->out->part1 = solve_part1(p->points, p->point_count);
+  bench_phase_end(BENCH_PHASE_PART1);
+}
 
-  return biggest_area;
+static void part2_task(void *arg) {
+  parts *const p = arg;
+  bench_phase_begin(BENCH_PHASE_PART2);
+  p->out->part2 = solve_part2(p->points, p->point_count, p->vertical_buffer, p->horizontal_buffer);
+  bench_phase_end(BENCH_PHASE_PART2);
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// parse_input only hands out the points it wrote, nothing to reset between inputs. the edge buffers are allocated with
+// the points, the parts run as tasks and don't touch the scratch
+typedef struct day_state {
+  scratch scratch;
+  point *points;
+  edge *vertical_edges;
+  edge *horizontal_edges;
+} day_state;
+
+void *day09_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->scratch, 0);
+  return s;
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+void day09_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  free(s);
+}
 
-  point points[MAX_VERTICES] = {0};
+void day09_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
   uint32_t point_count = 0;
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  const uint64_t capacity = scan_count(input, '\n') + 1;
+  scratch_clear(&s->scratch);
+  s->points = scratch_new(&s->scratch, point, capacity);
+  s->vertical_edges = scratch_new(&s->scratch, edge, capacity);
+  s->horizontal_edges = scratch_new(&s->scratch, edge, capacity);
+  parse_input(input, s->points, &point_count);
+  bench_phase_end(BENCH_PHASE_PARSE);
+
+  out->part_count = 2;
+  parts p = {.points = s->points,
+             .point_count = point_count,
+             .vertical_buffer = s->vertical_edges,
+             .horizontal_buffer = s->horizontal_edges,
+             .out = out};
+  // part 2 is the expensive one. run it here and let part 1 be stolen
+  aoc_fork_parts(part2_task, &p, part1_task, &p);
+}
 
-  parse_input(input, points, &point_count);
-  free(input);
-
-  uint64_t part1 = solve_part1(points, point_count);
-  uint64_t part2 = solve_part2(points, point_count);
+AOC_DAY_DEFINE_SOLVE(day09)
 
-  printf("%lu\n", part1);
-  printf("%lu\n", part2);
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day09));
 }
-
+#endif
@@ -5,7 +5,13 @@
 
 #include "../ext/toolbelt/src/assert.h"
 #include "../ext/toolbelt/src/bitutils.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/counters.h"
+#include "../common/fastint.h"
+#include "../common/pool.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
+#include "../common/snapshot.h"
 
 // max number of lights -> 10
 // awk '{print length($1)-2}' day10/input.txt | sort -nu | tail -n1
@@ -14,9 +20,8 @@
 // this means there are a max of 2^10 states of lights
 #define MAX_LIGHT_STATES (1 << MAX_LIGHTS)
 
-// max number of machines -> 159 (increase to 200)
+// number of machines -> 159. they get one slot per line
 // wc -l day10/input.txt
-#define MAX_MACHINES 200
 
 // max number of buttons per machine -> 13 (increase to 16)
 // awk '{print NF-2}' day10/input.txt | sort -nu | tail -n1
@@ -75,7 +80,7 @@ static uint16_t parse_button(char *input, char **out) {
   do {
     ++input; // either the opening brace or a comma
     tlbt_assert_fmt(isdigit(*input), "expected digit, actual '%c' (%d)", *input, *input);
-    uint8_t affected_light = strtoul(input, &input, 10);
+    uint8_t affected_light = fastint_parse_u64(input, &input);
     button = TLBT_SET_BIT(button, affected_light);
     tlbt_assert_fmt(*input == ')' || *input == ',', "expected ')' or ',', actual '%c' (%d)", *input, *input);
   } while (*input == ',');
@@ -106,7 +111,7 @@ static uint8_t parse_joltage_requirements(char *input, char **out, uint16_t *con
     tlbt_assert_fmt(count < MAX_JOLTAGE_REQUIREMENTS, "too many joltage requirements, max: %u",
                     MAX_JOLTAGE_REQUIREMENTS);
     tlbt_assert_fmt(isdigit(*input), "expected digit, actual '%c' (%d)", *input, *input);
-    joltage_requirements[count++] = strtoul(input, &input, 10);
+    joltage_requirements[count++] = fastint_parse_u64(input, &input);
     tlbt_assert_fmt(joltage_requirements[count - 1] <= MAX_JOLTAGE_REQUIREMENT_VALUE,
                     "joltage too big. expected <= %u, actual %u", MAX_JOLTAGE_REQUIREMENT_VALUE,
                     joltage_requirements[count - 1]);
@@ -125,8 +130,9 @@ static void parse_machine(char *input, char **out, machine *const m) {
   *out = input;
 }
 
-static void parse_input(char *input, machine *const machines, uint8_t *const machine_count) {
-  uint8_t c = 0;
+// machines has room for one per line
+static void parse_input(char *input, machine *const machines, uint32_t *const machine_count) {
+  uint32_t c = *machine_count;
   for (;;) {
     switch (*input) {
     case '\0':
@@ -136,7 +142,6 @@ static void parse_input(char *input, machine *const machines, uint8_t *const mac
       ++input;
       break;
     case '[':
-      tlbt_assert_fmt(c < MAX_MACHINES, "too many machines, max: %u", MAX_MACHINES);
       parse_machine(input, &input, &machines[c++]);
       tlbt_assert_fmt(*input == '\n' || *input == '\0', "expected new line or zero terminator, actual '%c' (%d)",
                       *input, *input);
@@ -148,8 +153,8 @@ static void parse_input(char *input, machine *const machines, uint8_t *const mac
   }
 }
 
-static void print_machines(const machine *const machines, const uint8_t machine_count) {
-  for (uint8_t i = 0; i < machine_count; ++i) {
+static void print_machines(const machine *const machines, const uint32_t machine_count) {
+  for (uint32_t i = 0; i < machine_count; ++i) {
     putchar('[');
     uint8_t count = 16 - (__builtin_clz((uint32_t)machines[i].lights) - 16);
     for (int16_t j = 0; j < count; j++) {
@@ -185,10 +190,13 @@ inline static bool light_state_equals(const uint16_t left, const uint16_t right)
   return left == right;
 }
 
+AOC_COUNTER(hashmap_probes, "day10 hashmap probes")
+AOC_COUNTER(hashmap_inserts, "day10 hashmap inserts")
+
 #define TLBT_KEY_T uint16_t
 #define TLBT_KEY_T_NAME light_state
 #define TLBT_HASH_FUNC light_state_hash
-#define TLBT_EQUALS_FUNC light_state_equals
+#define TLBT_EQUALS_FUNC(l, r) (AOC_COUNT(hashmap_probes), light_state_equals(l, r))
 #define TLBT_BASE2_CAPACITY
 #define TLBT_DYNAMIC_MEMORY
 #define TLBT_STATIC
@@ -200,29 +208,45 @@ inline static bool light_state_equals(const uint16_t left, const uint16_t right)
 #define TLBT_STATIC
 #include "../ext/toolbelt/src/deque.h"
 
-static uint32_t solve_part1(const machine *const machines, const uint8_t machine_count) {
-  uint32_t solution = 0;
-
-  tlbt_set_light_state visited = {0};
-  tlbt_set_light_state_create(&visited, 256);
-
-  tlbt_deque_light_state states = {0};
-  tlbt_deque_light_state_create(&states, 256);
+// the bfs containers of one worker. created the first time the worker gets machines of this state, big enough for every
+// light state so they never grow
+typedef struct bfs_scratch {
+  tlbt_set_light_state visited;
+  tlbt_deque_light_state states;
+} bfs_scratch;
+
+typedef struct part1_args {
+  const machine *machines;
+  bfs_scratch *scratch; // POOL_MAX_THREADS of them
+} part1_args;
+
+static uint64_t solve_machines(void *arg, const uint64_t begin, const uint64_t end) {
+  const part1_args *const args = arg;
+  const machine *const machines = args->machines;
+  bfs_scratch *const scratch = &args->scratch[pool_worker_index()];
+  if (!scratch->visited.keys) {
+    tlbt_set_light_state_create(&scratch->visited, MAX_LIGHT_STATES * 2);
+    tlbt_deque_light_state_create(&scratch->states, MAX_LIGHT_STATES);
+  }
+  tlbt_set_light_state *const visited = &scratch->visited;
+  tlbt_deque_light_state *const states = &scratch->states;
+  uint64_t solution = 0;
 
-  for (uint8_t i = 0; i < machine_count; ++i) {
-    tlbt_set_light_state_clear(&visited);
-    tlbt_deque_light_state_clear(&states);
+  for (uint64_t i = begin; i < end; ++i) {
+    tlbt_set_light_state_clear(visited);
+    tlbt_deque_light_state_clear(states);
 
     uint16_t start = 0;
     const uint16_t goal = machines[i].lights;
-    tlbt_set_light_state_insert(&visited, start);
-    tlbt_deque_light_state_push_back(&states, start);
+    AOC_COUNT(hashmap_inserts);
+    tlbt_set_light_state_insert(visited, start);
+    tlbt_deque_light_state_push_back(states, start);
     uint32_t moves = 0;
-    while (states.count > 0) {
-      const size_t state_count = states.count;
+    while (states->count > 0) {
+      const size_t state_count = states->count;
       for (size_t j = 0; j < state_count; ++j) {
-        const uint16_t current = *tlbt_deque_light_state_peek_front(&states);
-        tlbt_deque_light_state_pop_front(&states);
+        const uint16_t current = *tlbt_deque_light_state_peek_front(states);
+        tlbt_deque_light_state_pop_front(states);
 
         for (uint8_t b = 0; b < machines[i].button_count; ++b) {
           const uint16_t next = current ^ machines[i].buttons[b];
@@ -231,9 +255,10 @@ static uint32_t solve_part1(const machine *const machines, const uint8_t machine
             goto next_machine;
           }
           const uint32_t hash = light_state_hash(next);
-          if (!tlbt_set_light_state_contains_ph(&visited, next, hash)) {
-            tlbt_set_light_state_insert_ph(&visited, next, hash);
-            tlbt_deque_light_state_push_back(&states, next);
+          if (!tlbt_set_light_state_contains_ph(visited, next, hash)) {
+            AOC_COUNT(hashmap_inserts);
+            tlbt_set_light_state_insert_ph(visited, next, hash);
+            tlbt_deque_light_state_push_back(states, next);
           }
         }
       }
@@ -241,29 +266,105 @@ static uint32_t solve_part1(const machine *const machines, const uint8_t machine
     }
   next_machine:;
   }
-
-  tlbt_deque_light_state_destroy(&states);
-  tlbt_set_light_state_destroy(&visited);
   return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// every machine is its own bfs
+static uint64_t solve_part1(const machine *const machines, const uint32_t machine_count, bfs_scratch *const scratch) {
+  part1_args args = {.machines = machines, .scratch = scratch};
+  return pool_parallel_reduce(0, machine_count, 4, solve_machines, &args, pool_sum, 0);
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+// parse_machine sets every field of the machines it uses. the machines come from the arena, one slot per line
+typedef struct day_state {
+  scratch arena;
+  machine *machines;
+  bfs_scratch scratch[POOL_MAX_THREADS];
+} day_state;
+
+void *day10_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->arena, 0);
+  memset(s->scratch, 0, sizeof(s->scratch));
+  return s;
+}
 
-  machine machines[MAX_MACHINES] = {0};
-  uint8_t machine_count = 0;
+void day10_destroy(void *const state) {
+  day_state *const s = state;
+  for (uint32_t i = 0; i < POOL_MAX_THREADS; ++i) {
+    if (!s->scratch[i].visited.keys)
+      continue;
+    tlbt_deque_light_state_destroy(&s->scratch[i].states);
+    tlbt_set_light_state_destroy(&s->scratch[i].visited);
+  }
+  scratch_destroy(&s->arena);
+  free(s);
+}
 
-  parse_input(input, machines, &machine_count);
-  free(input);
+static void parse(day_state *const s, const char *const buffer, const size_t length, uint32_t *const machine_count) {
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  scratch_clear(&s->arena);
+  s->machines = scratch_new(&s->arena, machine, scan_count(input, '\n') + 1);
+  parse_input(input, s->machines, machine_count);
+  bench_phase_end(BENCH_PHASE_PARSE);
+}
 
-  uint32_t part1 = solve_part1(machines, machine_count);
+static void solve(day_state *const s, const machine *const machines, const uint32_t machine_count,
+                  aoc_result *const out) {
+  out->part_count = 1;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  out->part1 = solve_part1(machines, machine_count, s->scratch);
+  bench_phase_end(BENCH_PHASE_PART1);
+}
+
+void day10_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  uint32_t machine_count = 0;
+  parse(s, buffer, length, &machine_count);
+  solve(s, s->machines, machine_count, out);
+}
+
+// just the machines
+#define SNAPSHOT_LAYOUT 1
+
+bool day10_emit_snapshot(void *const state, const char *const buffer, const size_t length,
+                         const char *const file_name) {
+  day_state *const s = state;
+  uint32_t machine_count = 0;
+  parse(s, buffer, length, &machine_count);
 
-  printf("%u\n", part1);
+  snapshot_writer w = {0};
+  snapshot_add(&w, s->machines, machine_count, sizeof(machine));
+  return snapshot_write(&w, file_name, 10, SNAPSHOT_LAYOUT);
 }
 
+bool day10_solve_snapshot(void *const state, const char *const file_name, aoc_result *const out) {
+  snapshot snap;
+  bench_phase_begin(BENCH_PHASE_LOAD);
+  const bool opened = snapshot_open(&snap, file_name, 10, SNAPSHOT_LAYOUT);
+  bench_phase_end(BENCH_PHASE_LOAD);
+  if (!opened)
+    return false;
+
+  uint64_t machine_count = 0;
+  const machine *const machines = snapshot_section_data(&snap, 0, sizeof(machine), &machine_count);
+  bool valid = machines && machine_count <= UINT32_MAX;
+  // the button count is the only field used to index
+  for (uint64_t i = 0; valid && i < machine_count; ++i)
+    valid = machines[i].button_count <= MAX_BUTTONS;
+  if (!valid)
+    fprintf(stderr, "%s: unexpected sections\n", file_name);
+  else
+    solve(state, machines, machine_count, out);
+  snapshot_close(&snap);
+  return valid;
+}
+
+AOC_DAY_DEFINE_SOLVE(day10)
+
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY_WITH_SNAPSHOT(day10));
+}
+#endif
@@ -1,19 +1,21 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../ext/toolbelt/src/assert.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/counters.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
+#include "../common/snapshot.h"
 
+// number of nodes -> 594. the arrays are sized from the input
 // wc -l day11/input.txt
-#define MAX_NODES 600 // 594 -> 600
 
 // grep -Po '(?<=\: ).+' day11/input.txt | awk '{print NF}' | sort -nu | tail -n 1
 #define MAX_CHILDREN 30 // 26 -> 30
 
-// grep -Po '(?<=\: ).+' day11/input.txt | grep -Po '\w+' | sort | uniq -c | sort -nk1 | awk 'END{print $1}'
-#define MAX_INPUT_NODES 28
-
 // grep -Po '^[a-z]+(?=\:)' day11/input.txt | sort | uniq -c | awk 'END{print $1}'
 // no entries with the same key
 
@@ -25,12 +27,10 @@ typedef union node_id {
 typedef struct node {
   struct node *children[MAX_CHILDREN];
   node_id id;
-  uint64_t path_count;
   uint8_t children_count;
 } node;
 
 #define TLBT_T node
-#define TLBT_DYNAMIC_MEMORY
 #define TLBT_BASE2_CAPACITY
 #define TLBT_STATIC
 #include "../ext/toolbelt/src/deque.h"
@@ -44,12 +44,16 @@ inline static bool node_id_compare_func(const node_id left, const node_id right)
   return left.uint_id == right.uint_id;
 }
 
+AOC_COUNTER(hashmap_probes, "day11 hashmap probes")
+AOC_COUNTER(hashmap_inserts, "day11 hashmap inserts")
+AOC_COUNTER(count_paths_calls, "day11 count_paths calls")
+
 #define TLBT_KEY_T node_id
 #define TLBT_KEY_T_NAME id
 #define TLBT_VALUE_T node *
 #define TLBT_VALUE_T_NAME node
 #define TLBT_HASH_FUNC node_id_hash_func
-#define TLBT_EQUALS_FUNC node_id_compare_func
+#define TLBT_EQUALS_FUNC(l, r) (AOC_COUNT(hashmap_probes), node_id_compare_func(l, r))
 #define TLBT_DYNAMIC_MEMORY
 #define TLBT_BASE2_CAPACITY
 #define TLBT_STATIC
@@ -59,9 +63,6 @@ typedef struct rack {
   tlbt_map_id_node nodes;
 } rack;
 
-#define TLBT_IMPLEMENTATION
-#include "../ext/toolbelt/src/arena.h"
-
 inline static void parse_id(char *input, char **output, node_id *const id) {
   tlbt_assert_fmt(input[0] >= 'a' && input[0] <= 'z', "expected lower case char, actual '%c' (%d)", *input, *input);
   tlbt_assert_fmt(input[1] >= 'a' && input[1] <= 'z', "expected lower case char, actual '%c' (%d)", *input, *input);
@@ -75,107 +76,132 @@ inline static void parse_id(char *input, char **output, node_id *const id) {
 }
 
 static void parse_input(char *input, rack *const r, tlbt_deque_node *const nodes) {
-  for (;;) {
-    switch (*input) {
-    case '\0':
-      return;
-    case '\n':
-      ++input;
-      break;
-    default: {
-      node_id id = {0};
-      parse_id(input, &input, &id);
-      tlbt_assert_fmt(*input == ':', "expected ':', actual '%c' (%d)\n", *input, *input);
+  while (*input != '\0') {
+    char *line_end = scan_find(input, '\n');
+    if (line_end == input) {
       ++input;
-      node *n = NULL;
-      if (!tlbt_map_id_node_get(&r->nodes, id, &n)) {
-        tlbt_deque_node_push_back(nodes, (node){0});
-        n = tlbt_deque_node_peek_back(nodes);
-        n->id = id;
-        n->children_count = 0;
-        n->path_count = UINT64_MAX;
-        tlbt_map_id_node_insert(&r->nodes, id, n);
-      }
+      continue;
+    }
 
-      do {
-        tlbt_assert_fmt(*input == ' ', "expected space, actual '%c' (%d)\n", *input, *input);
-        node_id child_id = {0};
-        parse_id(input + 1, &input, &child_id);
-        node *child = NULL;
-        if (!tlbt_map_id_node_get(&r->nodes, child_id, &child)) {
-          tlbt_deque_node_push_back(nodes, (node){0});
-          child = tlbt_deque_node_peek_back(nodes);
-          child->id = child_id;
-          child->children_count = 0;
-          child->path_count = UINT64_MAX;
-          tlbt_map_id_node_insert(&r->nodes, child_id, child);
-        }
-        n->children[n->children_count++] = child;
-      } while (*input == ' ');
-      break;
+    node_id id = {0};
+    parse_id(input, &input, &id);
+    tlbt_assert_fmt(*input == ':', "expected ':', actual '%c' (%d)\n", *input, *input);
+    ++input;
+    node *n = NULL;
+    if (!tlbt_map_id_node_get(&r->nodes, id, &n)) {
+      tlbt_deque_node_push_back(nodes, (node){0});
+      n = tlbt_deque_node_peek_back(nodes);
+      n->id = id;
+      n->children_count = 0;
+      AOC_COUNT(hashmap_inserts);
+      tlbt_map_id_node_insert(&r->nodes, id, n);
     }
+
+    // every child is a space followed by a three letter id
+    while (input < line_end) {
+      tlbt_assert_fmt(*input == ' ', "expected space, actual '%c' (%d)\n", *input, *input);
+      node_id child_id = {0};
+      parse_id(input + 1, &input, &child_id);
+      node *child = NULL;
+      if (!tlbt_map_id_node_get(&r->nodes, child_id, &child)) {
+        tlbt_deque_node_push_back(nodes, (node){0});
+        child = tlbt_deque_node_peek_back(nodes);
+        child->id = child_id;
+        child->children_count = 0;
+        AOC_COUNT(hashmap_inserts);
+        tlbt_map_id_node_insert(&r->nodes, child_id, child);
+      }
+      tlbt_assert_fmt(n->children_count < MAX_CHILDREN, "too many children. max: %u", MAX_CHILDREN);
+      n->children[n->children_count++] = child;
     }
+    tlbt_assert_fmt(input == line_end, "expected new line or zero terminator, actual '%c' (%d)\n", *input, *input);
+    input = line_end + (*line_end == '\n');
   }
 }
 
+// the solvers walk the nodes as a csr graph: the children of node i are children[offsets[i]..offsets[i + 1]], nodes are
+// their position in the deque. no pointers, so a snapshot can be solved straight from the mapped file
+typedef struct graph {
+  const uint32_t *ids; // node_id.uint_id
+  const uint32_t *offsets;
+  const uint32_t *children;
+  uint32_t node_count;
+} graph;
+
+#define NO_NODE UINT32_MAX
+
 static const node_id you_id = {.string_id = "you"};
 static const node_id svr_id = {.string_id = "svr"};
 static const node_id fft_id = {.string_id = "fft"};
 static const node_id dac_id = {.string_id = "dac"};
 static const node_id out_id = {.string_id = "out"};
 
-static uint64_t count_paths(node *const n, const node_id dest) {
-  if (n->path_count != UINT64_MAX)
-    return n->path_count;
+// only a handful of lookups per solve, a scan is fine
+static uint32_t graph_find(const graph *const g, const node_id id) {
+  for (uint32_t i = 0; i < g->node_count; ++i)
+    if (g->ids[i] == id.uint_id)
+      return i;
+  return NO_NODE;
+}
+
+static void clear_cached_values(uint64_t *const path_counts, const uint32_t node_count) {
+  for (uint32_t i = 0; i < node_count; ++i)
+    path_counts[i] = UINT64_MAX;
+}
+
+static uint64_t count_paths(const graph *const g, uint64_t *const path_counts, const uint32_t n, const node_id dest) {
+  AOC_COUNT(count_paths_calls);
+  if (path_counts[n] != UINT64_MAX)
+    return path_counts[n];
 
-  if (n->id.uint_id == dest.uint_id)
+  if (g->ids[n] == dest.uint_id)
     return 1;
 
-  if (n->id.uint_id == out_id.uint_id)
+  if (g->ids[n] == out_id.uint_id)
     return 0;
 
-  n->path_count = 0;
-  for (uint8_t i = 0; i < n->children_count; ++i) {
-    n->path_count += count_paths(n->children[i], dest);
+  path_counts[n] = 0;
+  for (uint32_t i = g->offsets[n]; i < g->offsets[n + 1]; ++i) {
+    path_counts[n] += count_paths(g, path_counts, g->children[i], dest);
   }
 
-  return n->path_count;
+  return path_counts[n];
+}
+
+// one walk with a fresh cache. part 2 needs five of them
+static uint64_t count_paths_pass(const graph *const g, uint64_t *const path_counts, const uint32_t n,
+                                 const node_id dest) {
+  bench_section_begin("count paths pass");
+  clear_cached_values(path_counts, g->node_count);
+  const uint64_t paths = count_paths(g, path_counts, n, dest);
+  bench_section_end("count paths pass");
+  return paths;
 }
 
-static uint64_t solve_part1(rack *const r) {
+static uint64_t solve_part1(const graph *const g, uint64_t *const path_counts) {
   uint64_t solution = 0;
 
-  node *start = NULL;
-  tlbt_map_id_node_get(&r->nodes, you_id, &start);
-  solution = count_paths(start, out_id);
+  const uint32_t start = graph_find(g, you_id);
+  tlbt_assert(start != NO_NODE);
+  solution = count_paths_pass(g, path_counts, start, out_id);
 
   return solution;
 }
 
-static void clear_cached_values(tlbt_deque_node *const nodes) {
-  for (size_t i = 0; i < nodes->count; ++i)
-    nodes->data[i].path_count = UINT64_MAX;
-}
-
-static uint64_t solve_part2(rack *const r, tlbt_deque_node *const nodes) {
+static uint64_t solve_part2(const graph *const g, uint64_t *const path_counts) {
   uint64_t solution = 1;
 
-  node *svr = NULL;
-  node *dac = NULL;
-  node *fft = NULL;
-  tlbt_map_id_node_get(&r->nodes, svr_id, &svr);
-  tlbt_map_id_node_get(&r->nodes, dac_id, &dac);
-  tlbt_map_id_node_get(&r->nodes, fft_id, &fft);
-  tlbt_assert(svr && dac && fft);
+  const uint32_t svr = graph_find(g, svr_id);
+  const uint32_t dac = graph_find(g, dac_id);
+  const uint32_t fft = graph_find(g, fft_id);
+  tlbt_assert(svr != NO_NODE && dac != NO_NODE && fft != NO_NODE);
 
-  clear_cached_values(nodes);
-  const uint32_t paths_from_dac_to_fft = count_paths(dac, fft_id);
+  const uint32_t paths_from_dac_to_fft = count_paths_pass(g, path_counts, dac, fft_id);
 
-  clear_cached_values(nodes);
-  const uint32_t paths_from_fft_to_dac = count_paths(fft, dac_id);
+  const uint32_t paths_from_fft_to_dac = count_paths_pass(g, path_counts, fft, dac_id);
 
-  node *first = NULL;
-  node *second = NULL;
+  uint32_t first = NO_NODE;
+  uint32_t second = NO_NODE;
 
   if (paths_from_dac_to_fft > 0) {
     tlbt_assert(paths_from_fft_to_dac == 0);
@@ -186,48 +212,194 @@ static uint64_t solve_part2(rack *const r, tlbt_deque_node *const nodes) {
     first = fft;
     second = dac;
   }
+  tlbt_assert(first != NO_NODE);
+  const node_id second_id = {.uint_id = g->ids[second]};
 
   // calculate the amount of paths from the start "svr" to the first node (either fft or dac)
   // then calculate the amount of paths from the first node to the second node (if the first was fft, then second is
   // dac) then calculate the amount of paths from the second node to the end node "out". multiplying them together
   // should be the solution
-  clear_cached_values(nodes);
-  solution *= count_paths(svr, first->id);
+  solution *= count_paths_pass(g, path_counts, svr, (node_id){.uint_id = g->ids[first]});
 
-  clear_cached_values(nodes);
-  solution *= count_paths(first, second->id);
+  solution *= count_paths_pass(g, path_counts, first, second_id);
 
-  clear_cached_values(nodes);
-  solution *= count_paths(second, out_id);
+  solution *= count_paths_pass(g, path_counts, second, out_id);
 
   return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
+// the nodes point at each other, so their deque lives in the scratch with a fixed capacity and never moves them. the
+// csr arrays and the path counts come from the scratch too, sized once the nodes are known
+typedef struct day_state {
+  scratch scratch;
+  tlbt_deque_node nodes;
+  rack r;
+} day_state;
+
+void *day11_create(void) {
+  day_state *const s = malloc(sizeof(day_state));
+  scratch_create(&s->scratch, 0);
+  s->r = (rack){0};
+  tlbt_map_id_node_create(&s->r.nodes, 1024);
+  return s;
+}
 
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+void day11_destroy(void *const state) {
+  day_state *const s = state;
+  scratch_destroy(&s->scratch);
+  tlbt_map_id_node_destroy(&s->r.nodes);
+  free(s);
+}
+
+// flattens the parsed nodes into csr arrays in the scratch
+static graph build_graph(day_state *const s) {
+  const tlbt_deque_node *const nodes = &s->nodes;
+  uint64_t total_children = 0;
+  for (uint32_t i = 0; i < nodes->count; ++i)
+    total_children += nodes->data[i].children_count;
+  tlbt_assert_fmt(total_children < UINT32_MAX, "too many edges. max: %u", UINT32_MAX - 1);
+
+  uint32_t *const ids = scratch_new(&s->scratch, uint32_t, nodes->count);
+  uint32_t *const offsets = scratch_new(&s->scratch, uint32_t, nodes->count + 1);
+  uint32_t *const children = scratch_new(&s->scratch, uint32_t, total_children);
+  uint32_t child_count = 0;
+  for (uint32_t i = 0; i < nodes->count; ++i) {
+    const node *const n = &nodes->data[i];
+    ids[i] = n->id.uint_id;
+    offsets[i] = child_count;
+    for (uint8_t c = 0; c < n->children_count; ++c)
+      children[child_count++] = n->children[c] - nodes->data;
+  }
+  offsets[nodes->count] = child_count;
+  return (graph){.ids = ids, .offsets = offsets, .children = children, .node_count = nodes->count};
+}
+
+// three lower case letters
+#define NODE_ID_COUNT (26 * 26 * 26)
+
+static inline bool is_id_char(const char c) {
+  return c >= 'a' && c <= 'z';
+}
+
+// distinct ids in the input, so the nodes can be sized before parsing. there are only 26^3 of them, a bit per id is
+// enough to tell them apart. parse_input checks the syntax, this only picks out the runs of three letters
+static uint32_t count_node_ids(const char *p) {
+  uint64_t seen[(NODE_ID_COUNT + 63) / 64] = {0};
+  uint32_t count = 0;
+  while (*p != '\0') {
+    if (!is_id_char(p[0]) || !is_id_char(p[1]) || !is_id_char(p[2])) {
+      ++p;
+      continue;
+    }
+    const uint32_t id = (p[0] - 'a') * 26 * 26 + (p[1] - 'a') * 26 + (p[2] - 'a');
+    const uint64_t bit = 1ull << (id % 64);
+    count += (seen[id / 64] & bit) == 0;
+    seen[id / 64] |= bit;
+    p += 3;
+  }
+  return count;
+}
 
-  tlbt_deque_node nodes = {0};
-  tlbt_deque_node_create(&nodes, 1024);
+static graph parse(day_state *const s, const char *const buffer, const size_t length) {
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  char *const input = aoc_input(buffer, length);
+  const uint32_t node_count = count_node_ids(input);
+  // base 2 for the deque
+  size_t capacity = 16;
+  while (capacity < node_count)
+    capacity *= 2;
+  scratch_clear(&s->scratch);
+  tlbt_deque_node_init(&s->nodes, capacity, scratch_new(&s->scratch, node, capacity));
+  // every node ends up in the map. big enough up front, so it doesn't rehash while parsing
+  if (((uint64_t)node_count + 1) * 4 > s->r.nodes.capacity * 3) {
+    size_t map_capacity = s->r.nodes.capacity;
+    while (((uint64_t)node_count + 1) * 4 > map_capacity * 3)
+      map_capacity *= 2;
+    tlbt_map_id_node_destroy(&s->r.nodes);
+    tlbt_map_id_node_create(&s->r.nodes, map_capacity);
+  }
+  tlbt_map_id_node_clear(&s->r.nodes);
+  parse_input(input, &s->r, &s->nodes);
+  const graph g = build_graph(s);
+  bench_phase_end(BENCH_PHASE_PARSE);
+  return g;
+}
+
+static void solve(day_state *const s, const graph *const g, aoc_result *const out) {
+  out->part_count = 2;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  uint64_t *const path_counts = scratch_new(&s->scratch, uint64_t, g->node_count);
+  out->part1 = solve_part1(g, path_counts);
+  bench_phase_end(BENCH_PHASE_PART1);
+  bench_phase_begin(BENCH_PHASE_PART2);
+  out->part2 = solve_part2(g, path_counts);
+  bench_phase_end(BENCH_PHASE_PART2);
+}
+
+void day11_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  day_state *const s = state;
+  const graph g = parse(s, buffer, length);
+  solve(s, &g, out);
+}
 
-  rack r = {0};
-  tlbt_map_id_node_create(&r.nodes, 1024);
+// the three csr arrays
+#define SNAPSHOT_LAYOUT 1
 
-  parse_input(input, &r, &nodes);
-  free(input);
+bool day11_emit_snapshot(void *const state, const char *const buffer, const size_t length,
+                         const char *const file_name) {
+  day_state *const s = state;
+  const graph g = parse(s, buffer, length);
 
-  uint64_t part1 = solve_part1(&r);
-  uint64_t part2 = solve_part2(&r, &nodes);
+  snapshot_writer w = {0};
+  snapshot_add(&w, g.ids, g.node_count, sizeof(uint32_t));
+  snapshot_add(&w, g.offsets, g.node_count + 1, sizeof(uint32_t));
+  snapshot_add(&w, g.children, g.offsets[g.node_count], sizeof(uint32_t));
+  return snapshot_write(&w, file_name, 11, SNAPSHOT_LAYOUT);
+}
 
-  printf("%lu\n", part1);
-  printf("%lu\n", part2);
+// the solvers trust the offsets and children, so they are checked once here
+static bool graph_valid(const graph *const g, const uint64_t offset_count, const uint64_t child_count) {
+  if (!g->ids || !g->offsets || !g->children || offset_count != g->node_count + 1ull ||
+      g->offsets[0] != 0 || g->offsets[g->node_count] != child_count)
+    return false;
+  for (uint32_t i = 0; i < g->node_count; ++i)
+    if (g->offsets[i] > g->offsets[i + 1])
+      return false;
+  for (uint64_t i = 0; i < child_count; ++i)
+    if (g->children[i] >= g->node_count)
+      return false;
+  return true;
+}
 
-  tlbt_deque_node_destroy(&nodes);
-  tlbt_map_id_node_destroy(&r.nodes);
+bool day11_solve_snapshot(void *const state, const char *const file_name, aoc_result *const out) {
+  day_state *const s = state;
+  snapshot snap;
+  bench_phase_begin(BENCH_PHASE_LOAD);
+  const bool opened = snapshot_open(&snap, file_name, 11, SNAPSHOT_LAYOUT);
+  bench_phase_end(BENCH_PHASE_LOAD);
+  if (!opened)
+    return false;
+
+  uint64_t node_count = 0, offset_count = 0, child_count = 0;
+  graph g = {.ids = snapshot_section_data(&snap, 0, sizeof(uint32_t), &node_count),
+             .offsets = snapshot_section_data(&snap, 1, sizeof(uint32_t), &offset_count),
+             .children = snapshot_section_data(&snap, 2, sizeof(uint32_t), &child_count)};
+  g.node_count = node_count;
+  const bool valid = node_count < UINT32_MAX && graph_valid(&g, offset_count, child_count);
+  if (!valid) {
+    fprintf(stderr, "%s: unexpected sections\n", file_name);
+  } else {
+    scratch_clear(&s->scratch);
+    solve(s, &g, out);
+  }
+  snapshot_close(&snap);
+  return valid;
 }
 
+AOC_DAY_DEFINE_SOLVE(day11)
+
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY_WITH_SNAPSHOT(day11));
+}
+#endif
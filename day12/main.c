@@ -1,10 +1,15 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "../ext/toolbelt/src/assert.h"
 #include "../ext/toolbelt/src/bitutils.h"
-#include "../common/fileutils.h"
+#include "../common/aoc.h"
+#include "../common/fastint.h"
+#include "../common/pool.h"
+#include "../common/scan.h"
+#include "../common/scratch.h"
 
 #define PRESENT_WIDTH 3
 #define PRESENT_HEIGHT 3
@@ -17,8 +22,8 @@ typedef struct present_type {
 // grep -Po '^\d+(?=\:)' day12/input.txt | wc -l
 #define MAX_PRESENT_TYPES 6
 
+// number of regions -> 1000. they get one slot per line
 // grep 'x' day12/input.txt | wc -l
-#define MAX_REGIONS 1000
 
 typedef struct region {
   uint8_t width;
@@ -29,8 +34,9 @@ typedef struct region {
 typedef struct context {
   present_type present_types[MAX_PRESENT_TYPES];
   uint8_t present_type_count;
-  region regions[MAX_REGIONS];
-  uint16_t region_count;
+  scratch scratch;
+  region *regions;
+  uint32_t region_count;
 } context;
 
 static void parse_present_type(char *input, char **out, present_type *const t) {
@@ -65,7 +71,7 @@ static void parse_present_types(char *input, char **out, present_type *const p,
     default: {
       char *start = input;
       tlbt_assert_fmt(isdigit(*input), "digit expected, actual '%c' (%d)", *input, *input);
-      const uint8_t id = strtoul(input, &input, 10);
+      const uint8_t id = fastint_parse_u64(input, &input);
 
       switch (*input) {
       case ':':
@@ -89,24 +95,28 @@ static void parse_present_types(char *input, char **out, present_type *const p,
 
 static void parse_region(char *input, char **out, region *const r) {
   tlbt_assert_fmt(isdigit(*input), "digit expected, actual '%c' (%d)", *input, *input);
-  r->width = strtoul(input, &input, 10);
+  r->width = fastint_parse_u64(input, &input);
   tlbt_assert_fmt(*input == 'x', "expected 'x', actual '%c' (%d)", *input, *input);
   tlbt_assert_fmt(isdigit(input[1]), "digit expected, actual '%c' (%d)", *input, *input);
-  r->height = strtoul(input + 1, &input, 10);
+  r->height = fastint_parse_u64(input + 1, &input);
   tlbt_assert_fmt(*input == ':', "expected ':', actual '%c' (%d)", *input, *input);
   ++input;
   uint8_t count = 0;
   do {
     tlbt_assert_fmt(*input == ' ', "expected space, actual '%c' (%d)", *input, *input);
     tlbt_assert_fmt(count < MAX_PRESENT_TYPES, "too many present types for region, max: %u", MAX_PRESENT_TYPES);
-    r->counts[count++] = strtoul(input + 1, &input, 10); // +1 to skip the space
+    r->counts[count++] = fastint_parse_u64(input + 1, &input); // +1 to skip the space
   } while (*input == ' ');
+  // the regions aren't zeroed between inputs and solve reads a count for every present type
+  while (count < MAX_PRESENT_TYPES)
+    r->counts[count++] = 0;
 
   *out = input;
 }
 
-static void parse_regions(char *input, region *const regions, uint16_t *const region_count) {
-  uint16_t count = 0;
+// regions has room for one per line
+static void parse_regions(char *input, region *const regions, uint32_t *const region_count) {
+  uint32_t count = 0;
   tlbt_assert_fmt(isdigit(*input), "digit expected, actual '%c' (%d)", *input, *input);
 
   for (;;) {
@@ -118,7 +128,6 @@ static void parse_regions(char *input, region *const regions, uint16_t *const re
       ++input;
       break;
     default: {
-      tlbt_assert_fmt(count < MAX_REGIONS, "too many regions, max: %u", MAX_REGIONS);
       parse_region(input, &input, &regions[count++]);
       break;
     }
@@ -127,14 +136,17 @@ static void parse_regions(char *input, region *const regions, uint16_t *const re
 }
 
 static void parse_input(char *input, context *const ctx) {
+  scratch_clear(&ctx->scratch);
+  ctx->regions = scratch_new(&ctx->scratch, region, scan_count(input, '\n') + 1);
   parse_present_types(input, &input, ctx->present_types, &ctx->present_type_count);
   parse_regions(input, ctx->regions, &ctx->region_count);
 }
 
-static uint32_t solve(const context *const ctx) {
-  uint32_t solution = 0;
+static uint64_t count_fitting_regions(void *arg, const uint64_t begin, const uint64_t end) {
+  const context *const ctx = arg;
+  uint64_t solution = 0;
 
-  for (uint16_t i = 0; i < ctx->region_count; ++i) {
+  for (uint64_t i = begin; i < end; ++i) {
     const uint32_t target_area = (uint32_t)ctx->regions[i].width * (uint32_t)ctx->regions[i].height;
     uint32_t minimum_area_required = 0;
 
@@ -156,22 +168,41 @@ static uint32_t solve(const context *const ctx) {
   return solution;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2)
-    return 1;
-
-  char *input = NULL;
-  size_t length = 0;
-  if (!fileutils_read_all(argv[1], &input, &length))
-    return 1;
+// a region is only a handful of multiplications, so the chunks are big. anything smaller than a task per 256 regions
+// costs more in stealing than it saves
+static uint64_t solve(const context *const ctx) {
+  return pool_parallel_reduce(0, ctx->region_count, 256, count_fitting_regions, (void *)ctx, pool_sum, 0);
+}
 
-  context ctx = {0};
+// parse_input overwrites everything solve reads, so neither the context nor the regions are zeroed between inputs
+void *day12_create(void) {
+  context *const ctx = malloc(sizeof(context));
+  scratch_create(&ctx->scratch, 0);
+  return ctx;
+}
 
-  parse_input(input, &ctx);
-  free(input);
+void day12_destroy(void *const state) {
+  context *const ctx = state;
+  scratch_destroy(&ctx->scratch);
+  free(ctx);
+}
 
-  uint32_t solution = solve(&ctx);
+void day12_solve_with(void *const state, const char *const buffer, const size_t length, aoc_result *const out) {
+  context *const ctx = state;
+  bench_phase_begin(BENCH_PHASE_PARSE);
+  parse_input(aoc_input(buffer, length), ctx);
+  bench_phase_end(BENCH_PHASE_PARSE);
 
-  printf("%u\n", solution);
+  out->part_count = 1;
+  bench_phase_begin(BENCH_PHASE_PART1);
+  out->part1 = solve(ctx);
+  bench_phase_end(BENCH_PHASE_PART1);
 }
 
+AOC_DAY_DEFINE_SOLVE(day12)
+
+#ifndef AOC_LIBRARY
+int main(int argc, char **argv) {
+  return aoc_main(argc, argv, &(aoc_day)AOC_DAY(day12));
+}
+#endif
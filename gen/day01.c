@@ -0,0 +1,15 @@
+#include "gen.h"
+
+// one rotation per line. mostly small distances with some that go around the dial multiple times
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 1, argc, argv))
+    return 1;
+
+  const uint64_t rotations = gen_count(&g, 4000);
+  for (uint64_t i = 0; i < rotations; ++i) {
+    const char direction = gen_chance(&g, 0.5) ? 'L' : 'R';
+    const uint64_t distance = gen_range(&g, 1, gen_chance(&g, 0.2) ? 999 : 99);
+    printf("%c%lu\n", direction, distance);
+  }
+}
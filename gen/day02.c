@@ -0,0 +1,22 @@
+#include "gen.h"
+
+// a single line of comma separated ranges. both ends of a range have the same amount of digits or the upper one has one
+// more, just like in the real input
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 2, argc, argv))
+    return 1;
+
+  static const uint64_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+                                   10000000000};
+  const uint64_t ranges = gen_count(&g, 30);
+  for (uint64_t i = 0; i < ranges; ++i) {
+    const uint32_t digits = gen_range(&g, 1, 10);
+    const uint64_t from = gen_range(&g, pow10[digits - 1], pow10[digits] - 1);
+    uint64_t to = from + gen_range(&g, 0, pow10[digits < 3 ? 0 : digits - 3] * 5);
+    if (to >= pow10[digits + 1 > 10 ? 10 : digits + 1])
+      to = pow10[digits] - 1;
+    printf("%s%lu-%lu", i == 0 ? "" : ",", from, to);
+  }
+  printf("\n");
+}
@@ -0,0 +1,16 @@
+#include "gen.h"
+
+// one bank of 100 batteries (digits 1-9) per line
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 3, argc, argv))
+    return 1;
+
+  const uint64_t banks = gen_count(&g, 200);
+  char line[101] = {0};
+  for (uint64_t i = 0; i < banks; ++i) {
+    for (uint32_t j = 0; j < 100; ++j)
+      line[j] = '1' + gen_range(&g, 0, 8);
+    puts(line);
+  }
+}
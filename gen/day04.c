@@ -0,0 +1,17 @@
+#include "gen.h"
+
+// square grid of paper rolls. the density is close to the real input so the removal takes a few dozen rounds
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 4, argc, argv))
+    return 1;
+
+  const uint64_t side = gen_side(&g, 137);
+  char *line = calloc(side + 1, 1);
+  for (uint64_t y = 0; y < side; ++y) {
+    for (uint64_t x = 0; x < side; ++x)
+      line[x] = gen_chance(&g, 0.72) ? '@' : '.';
+    puts(line);
+  }
+  free(line);
+}
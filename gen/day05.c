@@ -0,0 +1,23 @@
+#include "gen.h"
+
+// fresh id ranges, an empty line and the available ids. the ranges overlap a lot because they are wide compared to the
+// id space
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 5, argc, argv))
+    return 1;
+
+  const uint64_t max_start = 100000000000000ull;
+  const uint64_t max_width = 1000000000000ull;
+
+  const uint64_t ranges = gen_count(&g, 174);
+  for (uint64_t i = 0; i < ranges; ++i) {
+    const uint64_t from = gen_range(&g, 1, max_start);
+    printf("%lu-%lu\n", from, from + gen_range(&g, 0, max_width));
+  }
+  printf("\n");
+
+  const uint64_t ids = gen_count(&g, 1000);
+  for (uint64_t i = 0; i < ids; ++i)
+    printf("%lu\n", gen_range(&g, 1, max_start + max_width));
+}
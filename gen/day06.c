@@ -0,0 +1,44 @@
+#include "gen.h"
+
+// four lines of numbers and one line of operators. every problem is a column block whose width is the longest number
+// in it. the shorter numbers are aligned left or right within the block, which matters for part 2
+#define NUMBER_LINES 4
+
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 6, argc, argv))
+    return 1;
+
+  const uint64_t problems = gen_count(&g, 1000);
+  // worst case is 4 digits plus separator per problem
+  char *lines[NUMBER_LINES + 1] = {0};
+  for (uint32_t i = 0; i <= NUMBER_LINES; ++i)
+    lines[i] = calloc(problems * 5 + 1, 1);
+
+  uint64_t column = 0;
+  for (uint64_t p = 0; p < problems; ++p) {
+    if (p > 0) {
+      for (uint32_t i = 0; i <= NUMBER_LINES; ++i)
+        lines[i][column] = ' ';
+      ++column;
+    }
+    const uint32_t width = gen_range(&g, 1, 4);
+    const bool align_right = gen_chance(&g, 0.5);
+    const uint32_t widest = gen_range(&g, 0, NUMBER_LINES - 1);
+    for (uint32_t i = 0; i < NUMBER_LINES; ++i) {
+      const uint32_t digits = i == widest ? width : gen_range(&g, 1, width);
+      const uint32_t offset = align_right ? width - digits : 0;
+      memset(lines[i] + column, ' ', width);
+      for (uint32_t d = 0; d < digits; ++d)
+        lines[i][column + offset + d] = '1' + gen_range(&g, 0, 8);
+    }
+    memset(lines[NUMBER_LINES] + column, ' ', width);
+    lines[NUMBER_LINES][column] = gen_chance(&g, 0.5) ? '+' : '*';
+    column += width;
+  }
+
+  for (uint32_t i = 0; i <= NUMBER_LINES; ++i) {
+    puts(lines[i]);
+    free(lines[i]);
+  }
+}
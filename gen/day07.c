@@ -0,0 +1,29 @@
+#include "gen.h"
+
+// the splitter manifold. the beam enters at S in the middle of the first line and splitters only sit on every other line
+// inside the triangle the beam can reach. the first splitter is always hit
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 7, argc, argv))
+    return 1;
+
+  const uint64_t width = gen_side(&g, 141) | 1; // odd so S is exactly in the middle
+  const uint64_t height = gen_side(&g, 142);
+  const uint64_t start = width / 2;
+
+  char *line = calloc(width + 1, 1);
+  for (uint64_t y = 0; y < height; ++y) {
+    memset(line, '.', width);
+    if (y == 0) {
+      line[start] = 'S';
+    } else if (y % 2 == 0) {
+      const uint64_t k = y / 2 - 1;
+      for (uint64_t x = start > k ? start - k : start % 2; x <= start + k && x < width - 1; x += 2) {
+        if (x > 0 && (y == 2 || gen_chance(&g, 0.7)))
+          line[x] = '^';
+      }
+    }
+    puts(line);
+  }
+  free(line);
+}
@@ -0,0 +1,16 @@
+#include "gen.h"
+
+// junction boxes with three coordinates in [0, 99999]
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 8, argc, argv))
+    return 1;
+
+  const uint64_t boxes = gen_count(&g, 1000);
+  for (uint64_t i = 0; i < boxes; ++i) {
+    const uint64_t x = gen_range(&g, 0, 99999);
+    const uint64_t y = gen_range(&g, 0, 99999);
+    const uint64_t z = gen_range(&g, 0, 99999);
+    printf("%lu,%lu,%lu\n", x, y, z);
+  }
+}
@@ -0,0 +1,30 @@
+#include "gen.h"
+
+// vertices of a rectilinear polygon in order. it's a skyline: a flat bottom edge and a staircase of horizontal edges
+// at random heights above it. consecutive vertices always share x or y and no two edges overlap
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 9, argc, argv))
+    return 1;
+
+  const uint64_t steps = gen_count(&g, 124);
+  // the coordinates grow with the input so the x values stay distinct
+  const uint64_t span = steps * 8 > 96000 ? steps * 8 : 96000;
+  const uint64_t bottom = span + 2000;
+  const uint64_t max_gap = span / steps * 2 - 1;
+
+  uint64_t x = gen_range(&g, 1000, 1000 + max_gap);
+  uint64_t previous_height = 0;
+  printf("%lu,%lu\n", x, bottom);
+  for (uint64_t i = 0; i < steps; ++i) {
+    uint64_t height = 0;
+    do {
+      height = gen_range(&g, 500, bottom - 1000);
+    } while (height == previous_height);
+    previous_height = height;
+    printf("%lu,%lu\n", x, height);
+    x += gen_range(&g, 1, max_gap);
+    printf("%lu,%lu\n", x, height);
+  }
+  printf("%lu,%lu\n", x, bottom);
+}
@@ -0,0 +1,49 @@
+#include "gen.h"
+
+// machines with 3-10 lights and 2-13 buttons. the light pattern is built by pressing a random subset of the buttons so
+// there always is a solution
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 10, argc, argv))
+    return 1;
+
+  const uint64_t machines = gen_count(&g, 159);
+  for (uint64_t m = 0; m < machines; ++m) {
+    const uint32_t light_count = gen_range(&g, 3, 10);
+    const uint32_t button_count = gen_range(&g, 2, 13);
+    uint16_t buttons[13] = {0};
+    for (uint32_t b = 0; b < button_count; ++b) {
+      const uint32_t affected = gen_range(&g, 1, light_count < 9 ? light_count : 9);
+      while ((uint32_t)__builtin_popcount(buttons[b]) < affected)
+        buttons[b] |= 1u << gen_range(&g, 0, light_count - 1);
+    }
+
+    uint16_t goal = 0;
+    while (goal == 0) {
+      for (uint32_t b = 0; b < button_count; ++b) {
+        if (gen_chance(&g, 0.5))
+          goal ^= buttons[b];
+      }
+    }
+
+    putchar('[');
+    for (uint32_t l = 0; l < light_count; ++l)
+      putchar(goal >> l & 1 ? '#' : '.');
+    putchar(']');
+    for (uint32_t b = 0; b < button_count; ++b) {
+      printf(" (");
+      bool first = true;
+      for (uint32_t l = 0; l < light_count; ++l) {
+        if (buttons[b] >> l & 1) {
+          printf("%s%u", first ? "" : ",", l);
+          first = false;
+        }
+      }
+      putchar(')');
+    }
+    printf(" {");
+    for (uint32_t l = 0; l < light_count; ++l)
+      printf("%s%lu", l == 0 ? "" : ",", gen_range(&g, 1, 269));
+    printf("}\n");
+  }
+}
@@ -0,0 +1,84 @@
+#include "gen.h"
+
+// a dag of devices with three letter names. the nodes are put in a random topological order with svr first, then you,
+// fft, dac and out in that order. edges only point forward and every node is connected to the next one, so all the
+// paths the puzzle asks for exist. the path counts grow exponentially with the size and wrap around at bigger scales
+#define NAME_COUNT (26 * 26 * 26)
+#define SPECIAL_COUNT 5
+#define WINDOW 40
+#define MAX_CHILDREN 4
+
+static void name(const uint32_t id, char *const out) {
+  out[0] = 'a' + id / (26 * 26);
+  out[1] = 'a' + id / 26 % 26;
+  out[2] = 'a' + id % 26;
+  out[3] = '\0';
+}
+
+static uint32_t id(const char *const s) {
+  return (s[0] - 'a') * 26 * 26 + (s[1] - 'a') * 26 + (s[2] - 'a');
+}
+
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 11, argc, argv))
+    return 1;
+
+  uint64_t random_count = gen_count(&g, 590);
+  if (random_count > NAME_COUNT - SPECIAL_COUNT) {
+    fprintf(stderr, "only %u three letter names available. capping\n", NAME_COUNT - SPECIAL_COUNT);
+    random_count = NAME_COUNT - SPECIAL_COUNT;
+  }
+
+  bool *taken = calloc(NAME_COUNT, sizeof(bool));
+  const char *const special[SPECIAL_COUNT] = {"svr", "you", "fft", "dac", "out"};
+  for (uint32_t i = 0; i < SPECIAL_COUNT; ++i)
+    taken[id(special[i])] = true;
+
+  // svr, a quarter of the random nodes, you, a quarter, fft, a quarter, dac, the rest, out
+  const uint64_t count = random_count + SPECIAL_COUNT;
+  uint32_t *order = malloc(sizeof(uint32_t) * count);
+  uint64_t next_special = 0;
+  uint64_t placed = 0;
+  for (uint64_t i = 0; i < count; ++i) {
+    if (next_special < SPECIAL_COUNT - 1 && placed == random_count * next_special / (SPECIAL_COUNT - 1)) {
+      order[i] = id(special[next_special++]);
+      continue;
+    }
+    if (i == count - 1) {
+      order[i] = id(special[SPECIAL_COUNT - 1]);
+      break;
+    }
+    uint32_t n = 0;
+    do {
+      n = gen_range(&g, 0, NAME_COUNT - 1);
+    } while (taken[n]);
+    taken[n] = true;
+    order[i] = n;
+    ++placed;
+  }
+
+  char buffer[4] = {0};
+  for (uint64_t i = 0; i < count - 1; ++i) {
+    // pick children from the next nodes in order. sorted output comes for free by marking positions
+    bool chosen[WINDOW] = {0};
+    const uint64_t window = count - 1 - i < WINDOW ? count - 1 - i : WINDOW;
+    const uint64_t children = gen_range(&g, 1, window < MAX_CHILDREN ? window : MAX_CHILDREN);
+    chosen[0] = true;
+    for (uint64_t c = 1; c < children; ++c)
+      chosen[gen_range(&g, 0, window - 1)] = true;
+
+    name(order[i], buffer);
+    printf("%s:", buffer);
+    for (uint64_t c = 0; c < window; ++c) {
+      if (chosen[c]) {
+        name(order[i + 1 + c], buffer);
+        printf(" %s", buffer);
+      }
+    }
+    printf("\n");
+  }
+
+  free(order);
+  free(taken);
+}
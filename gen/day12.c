@@ -0,0 +1,31 @@
+#include "gen.h"
+
+// six 3x3 present shapes followed by the regions. every region lists how many presents of each shape it needs
+#define PRESENT_TYPES 6
+
+int main(int argc, char **argv) {
+  gen g = {0};
+  if (!gen_init(&g, 12, argc, argv))
+    return 1;
+
+  for (uint32_t t = 0; t < PRESENT_TYPES; ++t) {
+    printf("%u:\n", t);
+    // the center is always set so no shape is empty
+    for (uint32_t y = 0; y < 3; ++y) {
+      for (uint32_t x = 0; x < 3; ++x)
+        putchar((x == 1 && y == 1) || gen_chance(&g, 0.7) ? '#' : '.');
+      putchar('\n');
+    }
+    putchar('\n');
+  }
+
+  const uint64_t regions = gen_count(&g, 1000);
+  for (uint64_t r = 0; r < regions; ++r) {
+    const uint64_t width = gen_range(&g, 5, 50);
+    const uint64_t height = gen_range(&g, 5, 50);
+    printf("%lux%lu:", width, height);
+    for (uint32_t t = 0; t < PRESENT_TYPES; ++t)
+      printf(" %lu", gen_range(&g, 0, 60));
+    printf("\n");
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// shared bits for the input generators. every generator writes one input to stdout
+//
+//   --scale <f>  size of the input relative to a real one (default 1). what gets scaled depends on the day, usually the
+//                line count. grids grow by sqrt(scale) per side so the cell count scales linearly
+//   --seed <n>   seed for the random numbers (default: the day). same seed and scale -> same file on every machine
+//
+// the generators only care about the puzzle format. the MAX_* limits of the solvers are not respected on purpose
+
+typedef struct gen {
+  double scale;
+  uint64_t state;
+} gen;
+
+// splitmix64. good enough for this and it doesn't depend on the libc rand implementation
+static inline uint64_t gen_u64(gen *const g) {
+  uint64_t z = (g->state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// inclusive on both ends
+static inline uint64_t gen_range(gen *const g, const uint64_t min, const uint64_t max) {
+  return min + gen_u64(g) % (max - min + 1);
+}
+
+static inline bool gen_chance(gen *const g, const double probability) {
+  return (double)(gen_u64(g) >> 11) * 0x1.0p-53 < probability;
+}
+
+// scaled count, at least 1
+static inline uint64_t gen_count(const gen *const g, const uint64_t base) {
+  const double n = base * g->scale;
+  return n < 1.0 ? 1 : (uint64_t)n;
+}
+
+// newton iterations, starting above the root so it converges from one side. saves linking libm for one call
+static inline double gen_sqrt(const double x) {
+  double s = x > 1.0 ? x : 1.0;
+  for (uint32_t i = 0; i < 64; ++i)
+    s = (s + x / s) / 2.0;
+  return s;
+}
+
+// scaled side length of a grid
+static inline uint64_t gen_side(const gen *const g, const uint64_t base) {
+  const double side = base * gen_sqrt(g->scale);
+  return side < 1.0 ? 1 : (uint64_t)side;
+}
+
+static inline bool gen_init(gen *const g, const uint32_t day, const int argc, char **argv) {
+  *g = (gen){.scale = 1.0};
+  uint64_t seed = day;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      g->scale = strtod(argv[++i], NULL);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--scale <f>] [--seed <n>]\n", argv[0]);
+      return false;
+    }
+  }
+  if (!(g->scale > 0.0)) {
+    fprintf(stderr, "--scale has to be positive\n");
+    return false;
+  }
+  g->state = seed;
+  return true;
+}